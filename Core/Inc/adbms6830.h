@@ -5,6 +5,7 @@
 /* ============================= INCLUDES ============================= */
 /* ==================================================================== */
 #include <stdint.h>
+#include <stdbool.h>
 
 /* ==================================================================== */
 /* ============================= DEFINES ============================== */
@@ -16,6 +17,7 @@
 
 #define COMMAND_SIZE_BYTES       2
 #define REGISTER_SIZE_BYTES      6
+#define ALL_REGISTER_SIZE_BYTES  32
 
 /* ==================================================================== */
 /* ========================= ENUMERATED TYPES========================== */
@@ -38,7 +40,25 @@ typedef enum
 void wakeChain(uint32_t numBmbs);
 TRANSACTION_STATUS_E commandAll(uint16_t command, uint32_t numBmbs);
 TRANSACTION_STATUS_E writeAll(uint16_t command, uint32_t numBmbs, uint8_t *txData);
-TRANSACTION_STATUS_E readAll(uint16_t command, uint32_t numBmbs, uint8_t *rxData);
+
+/*!
+  @brief   Poll every bmb in the chain for completion of an operation
+  @param   command     Poll command
+  @param   numBmbs     Number of bmbs in the chain
+  @param   complete    Set false if any reachable bmb is still busy
+  @return  TRANSACTION_SUCCESS if the poll reached the chain
+*/
+TRANSACTION_STATUS_E pollAll(uint16_t command, uint32_t numBmbs, bool *complete);
+
+/*!
+  @brief   Read a register group from every bmb in the chain
+  @param   command     Read command
+  @param   numBmbs     Number of bmbs in the chain
+  @param   rxData      Register data for each bmb in chain order
+  @param   bmbValid    Optional, set true for each bmb whose data passed CRC, even if the read failed overall
+  @return  TRANSACTION_CRC_ERROR if any bmb is missing data after all retries
+*/
+TRANSACTION_STATUS_E readAll(uint16_t command, uint32_t numBmbs, uint8_t *rxData, bool *bmbValid);
 
 #endif /* INC_ADBMS6830_H_ */
 
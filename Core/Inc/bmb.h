@@ -6,35 +6,169 @@
 /* ==================================================================== */
 #include <stdint.h>
 #include <adbms6830.h>
+#include "packStats.h"
+#include "thermistor.h"
 
 /* ==================================================================== */
 /* ============================= DEFINES ============================== */
 /* ==================================================================== */
 
-#define NUM_CELLS_PER_BMB 18
+#ifndef NUM_BMBS_IN_ACCUMULATOR
+#define NUM_BMBS_IN_ACCUMULATOR     1
+#endif
+
+// The ADBMS6830 measures 16 cells, one per brick of the bmb
+#define NUM_CELLS_PER_BMB 16
+#define NUM_GPIO_PER_BMB 10
+
+// Thermistors sit behind analog muxes whose outputs feed GPIO 1 and 2, with the channel selected by GPO 9-10
+#define NUM_THERMISTOR_MUX_INPUTS   2
+#define NUM_THERMISTOR_MUX_CHANNELS 4
+#define NUM_THERMISTORS_PER_BMB     (NUM_THERMISTOR_MUX_INPUTS * NUM_THERMISTOR_MUX_CHANNELS)
+
+// Status group C fault flags, as stored in bmbFaultFlags. Bits 0-7 are byte 4 of the group and bits 8-15 byte 5
+#define BMB_FAULT_VA_OV         (1UL << 0)      // Analog supply over or under voltage
+#define BMB_FAULT_VA_UV         (1UL << 1)
+#define BMB_FAULT_VD_OV         (1UL << 2)      // Digital supply over or under voltage
+#define BMB_FAULT_VD_UV         (1UL << 3)
+#define BMB_FAULT_CED           (1UL << 4)      // C-ADC and S-ADC conversion and multiplier errors
+#define BMB_FAULT_CMED          (1UL << 5)
+#define BMB_FAULT_SED           (1UL << 6)
+#define BMB_FAULT_SMED          (1UL << 7)
+#define BMB_FAULT_VDEL          (1UL << 8)      // Latent and present digital supply errors
+#define BMB_FAULT_VDE           (1UL << 9)
+#define BMB_FAULT_COMP          (1UL << 10)     // A C-ADC and S-ADC comparison has finished
+#define BMB_FAULT_SPIFLT        (1UL << 11)     // Fault on the SPI or isoSPI interface
+#define BMB_FAULT_SLEEP         (1UL << 12)     // The device went to sleep
+#define BMB_FAULT_THSD          (1UL << 13)     // Thermal shutdown
+#define BMB_FAULT_TMODCHK       (1UL << 14)     // Test mode detected
+#define BMB_FAULT_OSCCHK        (1UL << 15)     // Oscillator check failed
 
 /* ==================================================================== */
 /* ========================= ENUMERATED TYPES========================== */
 /* ==================================================================== */
 
+// Module voltages measured by the aux ADC, scaled down by 25 on the device
+typedef enum
+{
+    MODULE_VOLTAGE_VMV = 0,
+    MODULE_VOLTAGE_VPV,
+    NUM_MODULE_VOLTAGES
+} MODULE_VOLTAGE_E;
+
+// Internal voltages and die temperature reported in status groups A and B
 typedef enum
 {
-    UNINITIALIZED = 0,
-    GOOD,
-    BAD
-} SENSOR_STATUS_E;
+    STATUS_RESULT_VREF2 = 0,
+    STATUS_RESULT_ITMP,
+    STATUS_RESULT_VD,
+    STATUS_RESULT_VA,
+    STATUS_RESULT_VRES,
+    NUM_STATUS_RESULTS
+} STATUS_RESULT_E;
+
+// Register groups read by the diagnostic scheduler between scans
+// TODO: Add the mux fault class. The thermistor muxes sit outside the bmb, so no status group reports them failing
+// and a stuck mux has to be found from the thermistor readings instead
+typedef enum
+{
+    DIAGNOSTIC_REFERENCES = 0,      // Status group A: VREF2 and the die temperature
+    DIAGNOSTIC_SUPPLIES,            // Status group B: VD, VA and VRES
+    DIAGNOSTIC_FAULTS,              // Status group C: supply, ADC, interface, thermal and oscillator faults
+    NUM_DIAGNOSTICS
+} DIAGNOSTIC_E;
 
 /* ==================================================================== */
 /* ============================== STRUCTS============================== */
 /* ==================================================================== */
 
-// TODO add description
+// Measurements of every bmb in the accumulator, one array per measurement so pack wide sweeps read contiguous
+// memory. Entry [bmb][n] is measurement n of that bmb, kept as the signed 16-bit ADC code the bmb reports and
+// converted for display with the adcCodeTo helpers. Bit n of a bmb's validity mask is set when entry n is good
+typedef struct
+{
+    int16_t cellVoltage[NUM_BMBS_IN_ACCUMULATOR][NUM_CELLS_PER_BMB];
+    uint32_t cellVoltageValid[NUM_BMBS_IN_ACCUMULATOR];
+
+    // Thermistor voltages read through the muxes. Thermistor n is on GPIO (n % 2) + 1 with mux channel n / 2,
+    // and each scan updates the thermistors of one mux channel
+    int16_t thermistorVoltage[NUM_BMBS_IN_ACCUMULATOR][NUM_THERMISTORS_PER_BMB];
+    uint32_t thermistorVoltageValid[NUM_BMBS_IN_ACCUMULATOR];
+
+    // Thermistor temperatures in 0.1 C, converted from the voltages as each channel is read. A temperature is
+    // valid when its voltage is good and within the thermistor table, otherwise an open or short bit may be set
+    int16_t thermistorTemperature[NUM_BMBS_IN_ACCUMULATOR][NUM_THERMISTORS_PER_BMB];
+    uint32_t thermistorTemperatureValid[NUM_BMBS_IN_ACCUMULATOR];
+    uint32_t thermistorOpen[NUM_BMBS_IN_ACCUMULATOR];
+    uint32_t thermistorShort[NUM_BMBS_IN_ACCUMULATOR];
+
+    // Unaveraged C-ADC, filtered C-ADC and redundant S-ADC cell results
+    int16_t cAdcVoltage[NUM_BMBS_IN_ACCUMULATOR][NUM_CELLS_PER_BMB];
+    uint32_t cAdcVoltageValid[NUM_BMBS_IN_ACCUMULATOR];
+    int16_t filteredCellVoltage[NUM_BMBS_IN_ACCUMULATOR][NUM_CELLS_PER_BMB];
+    uint32_t filteredCellVoltageValid[NUM_BMBS_IN_ACCUMULATOR];
+    int16_t sAdcVoltage[NUM_BMBS_IN_ACCUMULATOR][NUM_CELLS_PER_BMB];
+    uint32_t sAdcVoltageValid[NUM_BMBS_IN_ACCUMULATOR];
+
+    // Aux ADC results
+    int16_t gpioVoltage[NUM_BMBS_IN_ACCUMULATOR][NUM_GPIO_PER_BMB];
+    uint32_t gpioVoltageValid[NUM_BMBS_IN_ACCUMULATOR];
+    int16_t moduleVoltage[NUM_BMBS_IN_ACCUMULATOR][NUM_MODULE_VOLTAGES];
+    uint32_t moduleVoltageValid[NUM_BMBS_IN_ACCUMULATOR];
+
+    // Status register results
+    int16_t statusResult[NUM_BMBS_IN_ACCUMULATOR][NUM_STATUS_RESULTS];
+    uint32_t statusResultValid[NUM_BMBS_IN_ACCUMULATOR];
+
+    // Bit n is set when cell n's unaveraged C-ADC and redundant S-ADC results of the same conversion disagree by
+    // more than the tolerance. Only cells valid in both cAdcVoltageValid and sAdcVoltageValid are compared. Cells
+    // are rechecked as their register groups are read, which may be one group per scan
+    uint32_t redundantAdcMismatch[NUM_BMBS_IN_ACCUMULATOR];
+
+    // S-ADC results of the last open wire conversion read, with the even or odd cell taps pulled down
+    int16_t openWireVoltage[NUM_BMBS_IN_ACCUMULATOR][NUM_CELLS_PER_BMB];
+    uint32_t openWireVoltageValid[NUM_BMBS_IN_ACCUMULATOR];
+
+    // Bit n is set when cell n's S-ADC result with either of its taps pulled down differs from its unaveraged C-ADC
+    // result, read alongside, by more than the open wire threshold, meaning a tap of the cell is open. Bit n of the validity mask is set
+    // once cell n was read in both polarities. A check updates one register group of cells at a time
+    uint32_t cellOpenWire[NUM_BMBS_IN_ACCUMULATOR];
+    uint32_t cellOpenWireValid[NUM_BMBS_IN_ACCUMULATOR];
+
+    // Hardware comparator flags, bit n is set when cell n crossed its limit since the previous flag poll
+    uint32_t cellOvervoltageFlags[NUM_BMBS_IN_ACCUMULATOR];
+    uint32_t cellUndervoltageFlags[NUM_BMBS_IN_ACCUMULATOR];
+    uint32_t cellVoltageFlagsValid[NUM_BMBS_IN_ACCUMULATOR];
+
+    // Status group C fault flags, see BMB_FAULT_. The faults latch on the device until it is reset
+    uint32_t bmbFaultFlags[NUM_BMBS_IN_ACCUMULATOR];
+    uint32_t bmbFaultFlagsValid[NUM_BMBS_IN_ACCUMULATOR];
+
+    // Set when a bmb's sum of cells result V+ differs from the sum of its cell voltages by more than the
+    // tolerance. Only bmbs with V+ and every cell valid are checked, each time updateBmbModuleVoltages reads V+
+    bool sumOfCellsMismatch[NUM_BMBS_IN_ACCUMULATOR];
+    bool sumOfCellsChecked[NUM_BMBS_IN_ACCUMULATOR];
+
+    // Sum of the V+ codes of every bmb with a valid V+, and how many there are. A coarse pack voltage from a
+    // single register group read, converted with adcCodeSumToModuleVolts
+    int32_t modulePackVoltage;
+    uint32_t numModulePackVoltages;
+} PackTelemetry_S;
+
+// Work done by the diagnostic scheduler since boot, per diagnostic
+typedef struct
+{
+    uint32_t runs[NUM_DIAGNOSTICS];
+    uint32_t forcedRuns[NUM_DIAGNOSTICS];       // Runs beyond the cycle's budget, to keep within the period
+    uint64_t busTimeUs[NUM_DIAGNOSTICS];        // Estimated from the length of each frame
+    uint32_t maxIntervalMs[NUM_DIAGNOSTICS];    // Longest time between two runs, or from the first call to the first run
+} DiagnosticStats_S;
+
+// Config A as read back by testRead
 typedef struct
-{   
-    float cellVoltage[NUM_CELLS_PER_BMB];
-    uint8_t testData[6];
+{
+    uint8_t testData[REGISTER_SIZE_BYTES];
     TRANSACTION_STATUS_E status;
-    SENSOR_STATUS_E cellVoltageStatus[NUM_CELLS_PER_BMB];
 } Bmb_S;
 
 
@@ -42,7 +176,149 @@ typedef struct
 /* =================== GLOBAL FUNCTION DECLARATIONS =================== */
 /* ==================================================================== */
 
-void updateBmbTelemetry(Bmb_S* bmb, uint32_t numBmbs);
-void testRead(Bmb_S* bmb, uint32_t numBmbs);
+/*!
+  @brief   Check whether the bmbs have finished converting, so a scan reads complete results.
+  @param   numBmbs - Number of bmbs in the chain.
+  @return  True once results are ready, or if the chain could not be polled.
+*/
+bool isBmbTelemetryReady(uint32_t numBmbs);
+
+/*!
+  @brief   Decode one bmb's data from a result register group into its measurements.
+  @param   pack - Pack telemetry to update.
+  @param   scanStats - Running pack statistics, updated with any averaged cell voltages. May be NULL.
+  @param   bmb - Index of the bmb in the chain.
+  @param   command - Read command that returned the data.
+  @param   registerData - The bmb's register data, laid out as returned by the read.
+  @return  False if any result was still cleared, meaning the bmb has not converted since reset.
+*/
+bool decodeRegisterGroup(PackTelemetry_S *pack, PackStatsAccumulator_S *scanStats, uint32_t bmb, uint16_t command, const uint8_t *registerData);
+
+/*!
+  @brief   Convert a cell, GPIO or status voltage code to volts.
+  @param   code - The ADC code.
+  @return  The voltage in volts.
+*/
+float adcCodeToVolts(int16_t code);
+
+/*!
+  @brief   Convert a difference between two voltage codes to volts.
+  @param   span - The difference in ADC codes.
+  @return  The difference in volts.
+*/
+float adcCodeSpanToVolts(int32_t span);
+
+/*!
+  @brief   Convert a sum of voltage codes to the sum of their voltages.
+  @param   sum - The sum of the ADC codes.
+  @param   numCodes - Number of codes in the sum.
+  @return  The sum of the voltages in volts.
+*/
+float adcCodeSumToVolts(int32_t sum, uint32_t numCodes);
+
+/*!
+  @brief   Convert a VMV or V+ module voltage code to volts.
+  @param   code - The ADC code.
+  @return  The module voltage in volts.
+*/
+float adcCodeToModuleVolts(int16_t code);
+
+/*!
+  @brief   Convert a sum of VMV or V+ module voltage codes to the sum of their voltages.
+  @param   sum - The sum of the ADC codes.
+  @param   numCodes - Number of codes in the sum.
+  @return  The sum of the module voltages in volts.
+*/
+float adcCodeSumToModuleVolts(int32_t sum, uint32_t numCodes);
+
+/*!
+  @brief   Convert the ITMP status result to the die temperature.
+  @param   code - The ADC code.
+  @return  The die temperature in degrees C.
+*/
+float adcCodeToDieTemperature(int16_t code);
+
+/*!
+  @brief   Scan the chain and decode the results. Pack statistics are gathered as each register group is
+           decoded, while its codes are still in cache, and published once the scan finishes. Each scan also
+           starts the aux conversion of one thermistor mux channel, read by updateBmbThermistors, and runs
+           the next step of the open wire check when its share of the bus allows.
+  @param   pack - Pack telemetry to update.
+  @param   stats - Replaced with the pack statistics once the scan finishes.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+void updateBmbTelemetry(PackTelemetry_S *pack, PackStats_S *stats, uint32_t numBmbs);
+
+/*!
+  @brief   Read only view of the pack statistics of the scan in progress, covering every cell decoded so far.
+           A bulk read decodes each bmb whole, so before the scan finishes this only differs from a complete
+           scan while bmbs whose bulk packet failed are read one register group at a time.
+  @return  Running statistics, which hold the last scan's once it has finished.
+*/
+const PackStatsAccumulator_S* getBmbScanStats(void);
+
+/*!
+  @brief   Check whether the thermistors converted during the last scan still need reading.
+  @return  True from the end of a scan until updateBmbThermistors has read its mux channel.
+*/
+bool isBmbThermistorReadoutDue(void);
+
+/*!
+  @brief   Read the thermistors of the mux channel converted during the last scan and select the next channel,
+           which then settles until the next scan. Meant for the time between scans, and only polls the aux
+           conversion if it has not finished yet.
+  @param   pack - Pack telemetry to update.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+void updateBmbThermistors(PackTelemetry_S *pack, uint32_t numBmbs);
+
+/*!
+  @brief   Check whether the sum of cells result is due to be converted, or converted and still to be read.
+  @return  True once a period has passed since the last conversion started, until updateBmbModuleVoltages reads it.
+*/
+bool isBmbModuleVoltageDue(void);
+
+/*!
+  @brief   Convert the sum of cells result of every bmb, or read it once converted, and check it against the cell
+           voltages. Each call either starts a conversion or polls it and reads the module voltages when done, so
+           it is called until isBmbModuleVoltageDue clears. A thermistor conversion in flight is read rather than
+           cut short.
+  @param   pack - Pack telemetry to update.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+void updateBmbModuleVoltages(PackTelemetry_S *pack, uint32_t numBmbs);
+/*!
+  @brief   Set the cell voltage limits every bmb compares each C-ADC result against in hardware. They are
+           written to the chain by the next updateCellVoltageFlags, and again whenever a bmb may have been reset.
+  @param   underVoltage - Cells below this voltage set their undervoltage flag.
+  @param   overVoltage - Cells above this voltage set their overvoltage flag.
+*/
+void setCellVoltageLimits(float underVoltage, float overVoltage);
+
+/*!
+  @brief   Read the hardware comparator flags of every cell, a fraction of the bus time of a full scan.
+           Flags are cleared once read, so each poll reports the crossings since the previous one.
+  @param   pack - Pack telemetry to update.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+void updateCellVoltageFlags(PackTelemetry_S *pack, uint32_t numBmbs);
+
+/*!
+  @brief   Read the diagnostic register group that is nearest its deadline, if the bus budget of the current cycle
+           covers it. A diagnostic that would miss its period by waiting for the next cycle runs regardless.
+           Meant for the time left between scans, and reads at most one group per call.
+  @param   pack - Pack telemetry to update.
+  @param   stats - Updated with the run and its bus time.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+void updateBmbDiagnostics(PackTelemetry_S *pack, DiagnosticStats_S *stats, uint32_t numBmbs);
+
+/*!
+  @brief   Write the next GPO pattern to config A and read it back into the first bmb's test data. The write
+           replaces the thermistor mux channel, so thermistor readings are unreliable while this runs.
+  @param   bmb - Test data of each bmb.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+void testRead(Bmb_S *bmb, uint32_t numBmbs);
 
 #endif /* INC_BMB_H_ */
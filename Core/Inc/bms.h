@@ -7,11 +7,11 @@
 
 #include <stdint.h>
 #include "bmb.h"
+#include "packStats.h"
 /* ==================================================================== */
 /* ============================= DEFINES ============================== */
 /* ==================================================================== */
 
-#define NUM_BMBS_IN_ACCUMULATOR     1
 #define NUM_BRICKS_PER_BMB          16
 
 /* ==================================================================== */
@@ -25,6 +25,9 @@
 typedef struct Bms
 {
 	uint32_t numBmbs;
+	PackTelemetry_S telemetry;
+	PackStats_S stats;					// Statistics of the last complete scan
+	DiagnosticStats_S diagnosticStats;	// Runs and bus time of the diagnostic reads between scans
 	Bmb_S bmb[NUM_BMBS_IN_ACCUMULATOR];
 
 } Bms_S;
@@ -33,6 +36,7 @@ typedef struct Bms
 /* =================== GLOBAL FUNCTION DECLARATIONS =================== */
 /* ==================================================================== */
 
+void initPackTelemetry();
 void updatePackTelemetry();
 void updateTestData();
 
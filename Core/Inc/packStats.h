@@ -0,0 +1,76 @@
+#ifndef INC_PACKSTATS_H_
+#define INC_PACKSTATS_H_
+
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include <stdint.h>
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+// Cell voltage statistics over every valid cell in the pack. Voltages are ADC codes, converted with
+// adcCodeToVolts, adcCodeSpanToVolts and adcCodeSumToVolts. Everything is zero when no cell is valid
+typedef struct
+{
+    uint32_t numValidCells;
+    int32_t sumCellVoltage;
+    int16_t minCellVoltage;
+    int16_t maxCellVoltage;
+    int16_t meanCellVoltage;        // Rounded toward zero
+    uint16_t cellVoltageSpread;     // Max minus min
+
+    // Location of the first cell holding the min and the max
+    uint8_t minCellBmb;
+    uint8_t minCell;
+    uint8_t maxCellBmb;
+    uint8_t maxCell;
+
+    // Core cycles the scan spent accumulating these, counted on the target unless PACK_STATS_MEASURE_CYCLES is cleared
+    uint32_t cycles;
+} PackStats_S;
+
+// Running cell voltage statistics of the scan in progress, covering every cell decoded so far.
+// Until a cell is accumulated the min is INT16_MAX, the max is INT16_MIN and both locations are 0xFF
+typedef struct
+{
+    uint32_t numValidCells;
+    int32_t sumCellVoltage;
+    int16_t minCellVoltage;
+    int16_t maxCellVoltage;
+    uint8_t minCellBmb;
+    uint8_t minCell;
+    uint8_t maxCellBmb;
+    uint8_t maxCell;
+    uint32_t cycles;
+} PackStatsAccumulator_S;
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DECLARATIONS =================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Clear the running statistics at the start of a scan.
+  @param   scanStats - Running statistics to clear.
+*/
+void resetPackStats(PackStatsAccumulator_S *scanStats);
+
+/*!
+  @brief   Add freshly decoded cell voltages of one bmb to the running statistics. Cells may arrive
+           in any order, ties still go to the first cell in the pack.
+  @param   scanStats - Running statistics to update.
+  @param   bmb - Index of the bmb in the chain.
+  @param   cells - Cell voltage codes of the bmb, indexed by cell.
+  @param   valid - Mask of the decoded cells that are good. Each cell must be added once per scan.
+*/
+void accumulatePackStats(PackStatsAccumulator_S *scanStats, uint32_t bmb, const int16_t *cells, uint32_t valid);
+
+/*!
+  @brief   Publish the running statistics of a finished scan in a single update.
+  @param   scanStats - Running statistics of the scan.
+  @param   stats - Replaced with the statistics of the scan.
+*/
+void publishPackStats(const PackStatsAccumulator_S *scanStats, PackStats_S *stats);
+
+#endif /* INC_PACKSTATS_H_ */
@@ -0,0 +1,40 @@
+#ifndef INC_PEC_H_
+#define INC_PEC_H_
+
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include <stdint.h>
+#include <stdbool.h>
+#include "adbms6830.h"
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+#define COMMAND_COUNTER_BITS    6
+
+#define CRC_SIZE_BYTES          2
+#define COMMAND_PACKET_LENGTH   (COMMAND_SIZE_BYTES + CRC_SIZE_BYTES)
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DECLARATIONS =================== */
+/* ==================================================================== */
+
+uint16_t calculateCommandCrc(uint8_t *packet, uint32_t numBytes);
+uint16_t calculateDataCrc(uint8_t *packet, uint32_t numBytes, uint8_t commandCounter);
+
+/*!
+  @brief   Write a command word and its command crc into a frame
+  @param   command     Command word to send
+  @param   frame       Destination for the COMMAND_PACKET_LENGTH byte frame
+*/
+void loadCommandFrame(uint16_t command, uint8_t *frame);
+
+/*!
+  @brief   Check the generated crc tables against a bitwise calculation
+  @return  True if every table entry and the datasheet example match
+*/
+bool pecSelfTest(void);
+
+#endif /* INC_PEC_H_ */
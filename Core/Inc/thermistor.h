@@ -0,0 +1,71 @@
+#ifndef INC_THERMISTOR_H_
+#define INC_THERMISTOR_H_
+
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include <stdint.h>
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// NTC thermistor curve, R = R0 * exp(B * (1 / T - 1 / T0)). The conversion table is generated from these at build time
+#ifndef THERMISTOR_BETA
+#define THERMISTOR_BETA                 3435.0
+#endif
+
+#ifndef THERMISTOR_NOMINAL_OHMS
+#define THERMISTOR_NOMINAL_OHMS         10000.0
+#endif
+
+#ifndef THERMISTOR_NOMINAL_C
+#define THERMISTOR_NOMINAL_C            25.0
+#endif
+
+// Each thermistor is the low side of a divider with a fixed resistor up to the bmb's VREF2
+#ifndef THERMISTOR_PULLUP_OHMS
+#define THERMISTOR_PULLUP_OHMS          10000.0
+#endif
+
+#ifndef THERMISTOR_SUPPLY_VOLTS
+#define THERMISTOR_SUPPLY_VOLTS         3.0
+#endif
+
+// The table covers 64 segments from the coldest temperature in steps of 0.1 C. Codes beyond the coldest end
+// are reported as an open thermistor and codes beyond the hottest end as a short
+#ifndef THERMISTOR_TABLE_MIN_DECI_C
+#define THERMISTOR_TABLE_MIN_DECI_C     (-400)
+#endif
+
+#ifndef THERMISTOR_TABLE_STEP_DECI_C
+#define THERMISTOR_TABLE_STEP_DECI_C    25
+#endif
+
+#define NUM_THERMISTOR_TABLE_SEGMENTS   64
+#define THERMISTOR_TABLE_MAX_DECI_C     (THERMISTOR_TABLE_MIN_DECI_C + (NUM_THERMISTOR_TABLE_SEGMENTS * THERMISTOR_TABLE_STEP_DECI_C))
+
+/* ==================================================================== */
+/* ========================= ENUMERATED TYPES========================== */
+/* ==================================================================== */
+
+typedef enum
+{
+    THERMISTOR_OK = 0,
+    THERMISTOR_OPEN,
+    THERMISTOR_SHORT
+} THERMISTOR_STATUS_E;
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DECLARATIONS =================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Convert a thermistor aux ADC code to its temperature by interpolating the generated table.
+  @param   code - The aux ADC code of the thermistor divider.
+  @param   temperature - Set to the temperature in 0.1 C, clamped to the table for an open or shorted thermistor.
+  @return  Whether the code is within the table, or reads as an open or shorted thermistor.
+*/
+THERMISTOR_STATUS_E thermistorCodeToTemperature(int16_t code, int16_t *temperature);
+
+#endif /* INC_THERMISTOR_H_ */
@@ -8,37 +8,69 @@
 #include "stm32f4xx_hal.h"
 #include "adbms6830.h"
 #include "spi.h"
+#include "pec.h"
 
 /* ==================================================================== */
 /* ============================= DEFINES ============================== */
 /* ==================================================================== */
 
-#define CRC_SIZE_BYTES          2
-#define CRC_LUT_SIZE            256
+#define REGISTER_PACKET_LENGTH   (REGISTER_SIZE_BYTES + CRC_SIZE_BYTES)
 
-// These crc values are left shifted 1 from the ADBMS6830 15bit crc
-// This prevents the need for a left shift after every crc calculation
-#define CRC_CMD_SEED            0x0020
-#define CRC_CMD_POLY            0x8B32
-#define CRC_CMD_SIZE            16
+// Bytes clocked after a poll command. The chain holds SDO low while any bmb is busy
+#define POLL_STATUS_BYTES        1
+#define POLL_COMPLETE            0xFF
 
-#define CRC_DATA_SEED           0x0010
-#define CRC_DATA_POLY           0x008F
-#define CRC_DATA_SIZE           10
+#define TRANSACTION_ATTEMPTS    3
 
-#define COMMAND_COUNTER_BITS    6
+// Chain probes are not retried. A probe lost to noise only underestimates the reachable bmbs,
+// which leaves the chain in a degraded state that is enumerated again
+#define PROBE_ATTEMPTS          1
+#define SPI_TIMEOUT_MS          10
 
-#define COMMAND_PACKET_LENGTH    (COMMAND_SIZE_BYTES + CRC_SIZE_BYTES)
-#define REGISTER_PACKET_LENGTH   (REGISTER_SIZE_BYTES + CRC_SIZE_BYTES)
+// DMA transfers complete with a single interrupt per frame instead of one per byte
+// Set to 0 to fall back to interrupt driven transfers
+#ifndef BMB_SPI_USE_DMA
+#define BMB_SPI_USE_DMA         1
+#endif
 
-#define TRANSACTION_ATTEMPTS    3
-#define SPI_TIMEOUT_MS          10
+#if BMB_SPI_USE_DMA
+#define BMB_SPI_TRANSACTION     HAL_SPI_TransmitReceive_DMA
+#else
+#define BMB_SPI_TRANSACTION     HAL_SPI_TransmitReceive_IT
+#endif
+
+// Each command is confirmed by a serial ID read of the command counter, and resent if a bmb missed it.
+// Set to 1 to skip that read and leave the check to the command counter in the PEC of the next register read
+#ifndef BMB_DEFER_COMMAND_VERIFY
+#define BMB_DEFER_COMMAND_VERIFY    0
+#endif
 
 #define DUAL_TRANSACTIONS_BEFORE_RETRY  100
 
+// The command counter wraps from 63 back to 1
+#define COMMAND_COUNTER_MAX     63
+#define COMMAND_COUNTER_CYCLE   63
+
 #define RESET_COMMAND_COUNTER_ADDRESS   0x002E
 #define READ_SERIAL_ID_COMMAND          0x002C
 
+// Config registers are verified by reading them back after a write
+#define WRITE_CONFIG_A_COMMAND          0x0001
+#define READ_CONFIG_A_COMMAND           0x0002
+#define WRITE_CONFIG_B_COMMAND          0x0024
+#define READ_CONFIG_B_COMMAND           0x0026
+
+// The GPO bits of config A read back the pin levels rather than the written values. GPO 1-8 fill byte 3 and
+// include the thermistor mux outputs, whose levels follow the thermistors, so they are left out of the compare.
+// GPO 9-10 in the low bits of byte 4 drive the mux select lines, which are pulled up and read back as written
+#define CONFIG_A_GPO_1_8_BYTE           3
+
+// Bulk read commands return every result register group in a single packet per bmb
+#define READ_ALL_CELL_VOLT_COMMAND      0x000C
+#define READ_ALL_AVG_VOLT_COMMAND       0x004C
+#define READ_ALL_S_VOLT_COMMAND         0x0010
+#define READ_ALL_FILT_VOLT_COMMAND      0x0018
+
 /* ==================================================================== */
 /* ======================= EXTERNAL VARIABLES ========================= */
 /* ==================================================================== */
@@ -74,51 +106,7 @@ typedef struct
     uint16_t localCommandCounter[NUM_PORTS];
 } CHAIN_INFO_S;
 
-typedef TRANSACTION_STATUS_E (*transactionPtr)(uint16_t, uint32_t, uint8_t*, PORT_E);
-
-/* ==================================================================== */
-/* ============================ CRC TABLES ============================ */
-/* ==================================================================== */
-
-uint16_t commandCrcTable[CRC_LUT_SIZE] = 
-{
-    0x0000, 0x8B32, 0x9D56, 0x1664, 0xB19E, 0x3AAC, 0x2CC8, 0xA7FA, 0xE80E, 0x633C, 0x7558, 0xFE6A, 0x5990, 0xD2A2, 0xC4C6, 0x4FF4,
-    0x5B2E, 0xD01C, 0xC678, 0x4D4A, 0xEAB0, 0x6182, 0x77E6, 0xFCD4, 0xB320, 0x3812, 0x2E76, 0xA544, 0x02BE, 0x898C, 0x9FE8, 0x14DA,
-    0xB65C, 0x3D6E, 0x2B0A, 0xA038, 0x07C2, 0x8CF0, 0x9A94, 0x11A6, 0x5E52, 0xD560, 0xC304, 0x4836, 0xEFCC, 0x64FE, 0x729A, 0xF9A8,
-    0xED72, 0x6640, 0x7024, 0xFB16, 0x5CEC, 0xD7DE, 0xC1BA, 0x4A88, 0x057C, 0x8E4E, 0x982A, 0x1318, 0xB4E2, 0x3FD0, 0x29B4, 0xA286,
-    0xE78A, 0x6CB8, 0x7ADC, 0xF1EE, 0x5614, 0xDD26, 0xCB42, 0x4070, 0x0F84, 0x84B6, 0x92D2, 0x19E0, 0xBE1A, 0x3528, 0x234C, 0xA87E,
-    0xBCA4, 0x3796, 0x21F2, 0xAAC0, 0x0D3A, 0x8608, 0x906C, 0x1B5E, 0x54AA, 0xDF98, 0xC9FC, 0x42CE, 0xE534, 0x6E06, 0x7862, 0xF350,
-    0x51D6, 0xDAE4, 0xCC80, 0x47B2, 0xE048, 0x6B7A, 0x7D1E, 0xF62C, 0xB9D8, 0x32EA, 0x248E, 0xAFBC, 0x0846, 0x8374, 0x9510, 0x1E22,
-    0x0AF8, 0x81CA, 0x97AE, 0x1C9C, 0xBB66, 0x3054, 0x2630, 0xAD02, 0xE2F6, 0x69C4, 0x7FA0, 0xF492, 0x5368, 0xD85A, 0xCE3E, 0x450C,
-    0x4426, 0xCF14, 0xD970, 0x5242, 0xF5B8, 0x7E8A, 0x68EE, 0xE3DC, 0xAC28, 0x271A, 0x317E, 0xBA4C, 0x1DB6, 0x9684, 0x80E0, 0x0BD2,
-    0x1F08, 0x943A, 0x825E, 0x096C, 0xAE96, 0x25A4, 0x33C0, 0xB8F2, 0xF706, 0x7C34, 0x6A50, 0xE162, 0x4698, 0xCDAA, 0xDBCE, 0x50FC,
-    0xF27A, 0x7948, 0x6F2C, 0xE41E, 0x43E4, 0xC8D6, 0xDEB2, 0x5580, 0x1A74, 0x9146, 0x8722, 0x0C10, 0xABEA, 0x20D8, 0x36BC, 0xBD8E,
-    0xA954, 0x2266, 0x3402, 0xBF30, 0x18CA, 0x93F8, 0x859C, 0x0EAE, 0x415A, 0xCA68, 0xDC0C, 0x573E, 0xF0C4, 0x7BF6, 0x6D92, 0xE6A0,
-    0xA3AC, 0x289E, 0x3EFA, 0xB5C8, 0x1232, 0x9900, 0x8F64, 0x0456, 0x4BA2, 0xC090, 0xD6F4, 0x5DC6, 0xFA3C, 0x710E, 0x676A, 0xEC58,
-    0xF882, 0x73B0, 0x65D4, 0xEEE6, 0x491C, 0xC22E, 0xD44A, 0x5F78, 0x108C, 0x9BBE, 0x8DDA, 0x06E8, 0xA112, 0x2A20, 0x3C44, 0xB776,
-    0x15F0, 0x9EC2, 0x88A6, 0x0394, 0xA46E, 0x2F5C, 0x3938, 0xB20A, 0xFDFE, 0x76CC, 0x60A8, 0xEB9A, 0x4C60, 0xC752, 0xD136, 0x5A04,
-    0x4EDE, 0xC5EC, 0xD388, 0x58BA, 0xFF40, 0x7472, 0x6216, 0xE924, 0xA6D0, 0x2DE2, 0x3B86, 0xB0B4, 0x174E, 0x9C7C, 0x8A18, 0x012A
-};
-
-uint16_t dataCrcTable[CRC_LUT_SIZE] = 
-{
-    0x0000, 0x048F, 0x091E, 0x0D91, 0x123C, 0x16B3, 0x1B22, 0x1FAD, 0x24F7, 0x2078, 0x2DE9, 0x2966, 0x36CB, 0x3244, 0x3FD5, 0x3B5A,
-    0x49EE, 0x4D61, 0x40F0, 0x447F, 0x5BD2, 0x5F5D, 0x52CC, 0x5643, 0x6D19, 0x6996, 0x6407, 0x6088, 0x7F25, 0x7BAA, 0x763B, 0x72B4,
-    0x93DC, 0x9753, 0x9AC2, 0x9E4D, 0x81E0, 0x856F, 0x88FE, 0x8C71, 0xB72B, 0xB3A4, 0xBE35, 0xBABA, 0xA517, 0xA198, 0xAC09, 0xA886,
-    0xDA32, 0xDEBD, 0xD32C, 0xD7A3, 0xC80E, 0xCC81, 0xC110, 0xC59F, 0xFEC5, 0xFA4A, 0xF7DB, 0xF354, 0xECF9, 0xE876, 0xE5E7, 0xE168,
-    0x2737, 0x23B8, 0x2E29, 0x2AA6, 0x350B, 0x3184, 0x3C15, 0x389A, 0x03C0, 0x074F, 0x0ADE, 0x0E51, 0x11FC, 0x1573, 0x18E2, 0x1C6D,
-    0x6ED9, 0x6A56, 0x67C7, 0x6348, 0x7CE5, 0x786A, 0x75FB, 0x7174, 0x4A2E, 0x4EA1, 0x4330, 0x47BF, 0x5812, 0x5C9D, 0x510C, 0x5583,
-    0xB4EB, 0xB064, 0xBDF5, 0xB97A, 0xA6D7, 0xA258, 0xAFC9, 0xAB46, 0x901C, 0x9493, 0x9902, 0x9D8D, 0x8220, 0x86AF, 0x8B3E, 0x8FB1,
-    0xFD05, 0xF98A, 0xF41B, 0xF094, 0xEF39, 0xEBB6, 0xE627, 0xE2A8, 0xD9F2, 0xDD7D, 0xD0EC, 0xD463, 0xCBCE, 0xCF41, 0xC2D0, 0xC65F,
-    0x4EE1, 0x4A6E, 0x47FF, 0x4370, 0x5CDD, 0x5852, 0x55C3, 0x514C, 0x6A16, 0x6E99, 0x6308, 0x6787, 0x782A, 0x7CA5, 0x7134, 0x75BB,
-    0x070F, 0x0380, 0x0E11, 0x0A9E, 0x1533, 0x11BC, 0x1C2D, 0x18A2, 0x23F8, 0x2777, 0x2AE6, 0x2E69, 0x31C4, 0x354B, 0x38DA, 0x3C55,
-    0xDD3D, 0xD9B2, 0xD423, 0xD0AC, 0xCF01, 0xCB8E, 0xC61F, 0xC290, 0xF9CA, 0xFD45, 0xF0D4, 0xF45B, 0xEBF6, 0xEF79, 0xE2E8, 0xE667,
-    0x94D3, 0x905C, 0x9DCD, 0x9942, 0x86EF, 0x8260, 0x8FF1, 0x8B7E, 0xB024, 0xB4AB, 0xB93A, 0xBDB5, 0xA218, 0xA697, 0xAB06, 0xAF89,
-    0x69D6, 0x6D59, 0x60C8, 0x6447, 0x7BEA, 0x7F65, 0x72F4, 0x767B, 0x4D21, 0x49AE, 0x443F, 0x40B0, 0x5F1D, 0x5B92, 0x5603, 0x528C,
-    0x2038, 0x24B7, 0x2926, 0x2DA9, 0x3204, 0x368B, 0x3B1A, 0x3F95, 0x04CF, 0x0040, 0x0DD1, 0x095E, 0x16F3, 0x127C, 0x1FED, 0x1B62,
-    0xFA0A, 0xFE85, 0xF314, 0xF79B, 0xE836, 0xECB9, 0xE128, 0xE5A7, 0xDEFD, 0xDA72, 0xD7E3, 0xD36C, 0xCCC1, 0xC84E, 0xC5DF, 0xC150,
-    0xB3E4, 0xB76B, 0xBAFA, 0xBE75, 0xA1D8, 0xA557, 0xA8C6, 0xAC49, 0x9713, 0x939C, 0x9E0D, 0x9A82, 0x852F, 0x81A0, 0x8C31, 0X88BE
-};
+typedef TRANSACTION_STATUS_E (*transactionPtr)(uint16_t, uint32_t, uint8_t*, bool*, PORT_E);
 
 /* ==================================================================== */
 /* ========================= LOCAL VARIABLES ========================== */
@@ -138,15 +126,22 @@ static void openPort(PORT_E port);
 static void closePort(PORT_E port);
 static void resetCommandCounter(PORT_E port);
 static void incCommandCounter(PORT_E port);
-static uint16_t calculateCommandCrc(uint8_t *packet, uint32_t numBytes);
-static uint16_t calculateDataCrc(uint8_t *packet, uint32_t numBytes, uint8_t commandCounter);
+static bool isCommandCounterAhead(uint8_t bmbCounter, uint8_t localCounter);
+static uint32_t getRegisterSize(uint16_t command);
+static uint16_t getReadbackCommand(uint16_t command);
+static bool isReadbackMatch(uint16_t command, const uint8_t *readback, const uint8_t *written);
 static TRANSACTION_STATUS_E sendCommand(uint16_t command, uint32_t numBmbs, PORT_E port);
 static TRANSACTION_STATUS_E writeRegister(uint16_t command, uint32_t numBmbs, uint8_t *txBuffer, PORT_E port);
-static TRANSACTION_STATUS_E readRegister(uint16_t command, uint32_t numBmbs, uint8_t *rxBuffer, PORT_E port);
-static TRANSACTION_STATUS_E sendAndVerifyCommand(uint16_t command, uint32_t numBmbs, uint8_t* buffer, PORT_E port);
-static TRANSACTION_STATUS_E writeAndVerifyRegister(uint16_t command, uint32_t numBmbs, uint8_t *txBuffer, PORT_E port);
-static TRANSACTION_STATUS_E sendMessageBmbChain(transactionPtr transaction, uint16_t command, uint32_t numBmbs, uint8_t *dataBuffer);
+static TRANSACTION_STATUS_E readRegisterFrame(uint16_t command, uint32_t numBmbs, uint8_t *rxBuffer, bool *bmbValid, PORT_E port);
+static TRANSACTION_STATUS_E readRegisterAttempts(uint16_t command, uint32_t numBmbs, uint8_t *rxBuffer, bool *bmbValid, PORT_E port, uint32_t attempts);
+static TRANSACTION_STATUS_E readRegister(uint16_t command, uint32_t numBmbs, uint8_t *rxBuffer, bool *bmbValid, PORT_E port);
+static TRANSACTION_STATUS_E pollCommand(uint16_t command, uint32_t numBmbs, uint8_t *rxBuffer, bool *complete, PORT_E port);
+static TRANSACTION_STATUS_E sendAndVerifyCommand(uint16_t command, uint32_t numBmbs, uint8_t* buffer, bool *bmbValid, PORT_E port);
+static TRANSACTION_STATUS_E writeAndVerifyRegister(uint16_t command, uint32_t numBmbs, uint8_t *txBuffer, bool *bmbValid, PORT_E port);
+static TRANSACTION_STATUS_E sendMessageBmbChain(transactionPtr transaction, uint16_t command, uint32_t numBmbs, uint8_t *dataBuffer, bool *bmbValid);
+static TRANSACTION_STATUS_E findAvailableBmbs(PORT_E port, uint32_t maxBmbs, uint8_t *rxBuff);
 static TRANSACTION_STATUS_E enumerateBmbs(uint32_t numBmbs);
+static TRANSACTION_STATUS_E resyncCommandCounters(uint32_t numBmbs);
 
 /* ==================================================================== */
 /* =================== LOCAL FUNCTION DEFINITIONS ===================== */
@@ -184,62 +179,72 @@ static void resetCommandCounter(PORT_E port)
 static void incCommandCounter(PORT_E port)
 {
     chainInfo.localCommandCounter[port]++;
-    if(chainInfo.localCommandCounter[port] > 63)
+    if(chainInfo.localCommandCounter[port] > COMMAND_COUNTER_MAX)
     {
         chainInfo.localCommandCounter[port] = 1;
     }
 }
 
-
-static uint16_t calculateCommandCrc(uint8_t *packet, uint32_t numBytes)
+static bool isCommandCounterAhead(uint8_t bmbCounter, uint8_t localCounter)
 {
-    // Begin crc calculation with intial value
-    uint16_t crc = CRC_CMD_SEED;
-
-    // For each byte of data, use lookup table to efficiently calculate crc
-    for(int32_t i = 0; i < numBytes; i++)
+    // Counters run 1-63 once any command is sent, so compare within that cycle. Any lead under half
+    // a cycle is taken as extra commands rather than missed ones
+    int32_t lead = (int32_t)bmbCounter - (int32_t)localCounter;
+    if(lead < 0)
     {
-        // Determine the next look up table index from the current crc and next data byte
-        uint8_t index = (uint8_t)((crc >> (CRC_CMD_SIZE - BITS_IN_BYTE)) ^ packet[i]);
-        
-        // Calculate the next intermediate crc from the current crc and look up table
-        crc = ((crc << BITS_IN_BYTE) ^ (uint16_t)(commandCrcTable[index]));
+        lead += COMMAND_COUNTER_CYCLE;
     }
-
-    return crc;
+    return (lead > 0) && (lead < (COMMAND_COUNTER_CYCLE / 2));
 }
 
-static uint16_t calculateDataCrc(uint8_t *packet, uint32_t numBytes, uint8_t commandCounter)
+static uint32_t getRegisterSize(uint16_t command)
 {
-    // Begin crc calculation with intial value
-    uint16_t crc = CRC_DATA_SEED;
-
-    // For each byte of data, use lookup table to efficiently calculate crc
-    for(int32_t i = 0; i < numBytes; i++)
+    // Determine the number of data bytes each bmb returns for a read command
+    switch(command)
     {
-        // Determine the next look up table index from the current crc and next data byte
-        uint8_t index = (uint8_t)((crc >> (CRC_DATA_SIZE - BITS_IN_BYTE)) ^ packet[i]);
-        
-        // Calculate the next intermediate crc from the current crc and look up table
-        crc = ((crc << BITS_IN_BYTE) ^ (uint16_t)(dataCrcTable[index]));
+        case READ_ALL_CELL_VOLT_COMMAND:
+        case READ_ALL_AVG_VOLT_COMMAND:
+        case READ_ALL_S_VOLT_COMMAND:
+        case READ_ALL_FILT_VOLT_COMMAND:
+            return ALL_REGISTER_SIZE_BYTES;
+        default:
+            return REGISTER_SIZE_BYTES;
     }
+}
 
-    // Clear bit shift residue
-    crc &= 0x03FF;
-
-    // Determine the next look up table index from the current crc and next data byte
-    uint8_t index = (uint8_t)((crc >> (CRC_DATA_SIZE - COMMAND_COUNTER_BITS)) ^ commandCounter);
-    
-    // Calculate the next intermediate crc from the current crc and look up table
-    crc = ((crc << COMMAND_COUNTER_BITS) ^ (uint16_t)(dataCrcTable[index]));
+static uint16_t getReadbackCommand(uint16_t command)
+{
+    // Determine the read command that returns the register group a write command sets
+    switch(command)
+    {
+        case WRITE_CONFIG_A_COMMAND:
+            return READ_CONFIG_A_COMMAND;
+        case WRITE_CONFIG_B_COMMAND:
+            return READ_CONFIG_B_COMMAND;
+        default:
+            return command + 1;
+    }
+}
 
-    // Clear bit shift residue
-    crc &= 0x03FF;
+static bool isReadbackMatch(uint16_t command, const uint8_t *readback, const uint8_t *written)
+{
+    uint8_t mask[REGISTER_SIZE_BYTES];
+    memset(mask, 0xFF, sizeof(mask));
+    if(command == WRITE_CONFIG_A_COMMAND)
+    {
+        mask[CONFIG_A_GPO_1_8_BYTE] = 0x00;
+    }
 
-    return crc;
+    for(int32_t i = 0; i < REGISTER_SIZE_BYTES; i++)
+    {
+        if((readback[i] ^ written[i]) & mask[i])
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
-
 static TRANSACTION_STATUS_E sendCommand(uint16_t command, uint32_t numBmbs, PORT_E port)
 {
     // Size in bytes: Command Word(2) + Command CRC(2)
@@ -249,18 +254,12 @@ static TRANSACTION_STATUS_E sendCommand(uint16_t command, uint32_t numBmbs, PORT
     uint8_t txBuffer[packetLength];
     uint8_t rxBuffer[packetLength];
 
-    // Populate the tx buffer with the command word
-    txBuffer[0] = (uint8_t)(command >> BITS_IN_BYTE);
-    txBuffer[1] = (uint8_t)(command);
-
-    // Calculate the CRC on the command word and place the tx buffer
-    uint16_t commandCRC = calculateCommandCrc(txBuffer, COMMAND_SIZE_BYTES);
-    txBuffer[2] = (uint8_t)(commandCRC >> BITS_IN_BYTE);
-    txBuffer[3] = (uint8_t)(commandCRC);
+    // Populate the tx buffer with the command word and CRC
+    loadCommandFrame(command, txBuffer);
 
     // SPIify
     openPort(port);
-    if(SPI_TRANSMIT(HAL_SPI_TransmitReceive_IT, &hspi1, SPI_TIMEOUT_MS, txBuffer, rxBuffer, packetLength) != SPI_SUCCESS)
+    if(SPI_TRANSMIT(BMB_SPI_TRANSACTION, &hspi1, SPI_TIMEOUT_MS, txBuffer, rxBuffer, packetLength) != SPI_SUCCESS)
     {
         closePort(port);
         return TRANSACTION_SPI_ERROR;
@@ -278,14 +277,8 @@ static TRANSACTION_STATUS_E writeRegister(uint16_t command, uint32_t numBmbs, ui
     uint8_t txBuffer[packetLength];
     uint8_t rxBuffer[packetLength];
     
-    // Populate the tx buffer with the command word
-    txBuffer[0] = (uint8_t)(command >> BITS_IN_BYTE);
-    txBuffer[1] = (uint8_t)(command);
-
-    // Calculate the CRC on the command word and place the tx buffer
-    uint16_t commandCRC = calculateCommandCrc(txBuffer, COMMAND_SIZE_BYTES);
-    txBuffer[2] = (uint8_t)(commandCRC >> BITS_IN_BYTE);
-    txBuffer[3] = (uint8_t)(commandCRC);
+    // Populate the tx buffer with the command word and CRC
+    loadCommandFrame(command, txBuffer);
 
     // Calculate the CRC on the register data packet (2 byte CRC on 6 byte packet)
     uint16_t dataCRC = calculateDataCrc(txBuff, REGISTER_SIZE_BYTES, 0);
@@ -300,7 +293,7 @@ static TRANSACTION_STATUS_E writeRegister(uint16_t command, uint32_t numBmbs, ui
 
     // SPIify
     openPort(port);
-    if(SPI_TRANSMIT(HAL_SPI_TransmitReceive_IT, &hspi1, SPI_TIMEOUT_MS, txBuffer, rxBuffer, packetLength) != SPI_SUCCESS)
+    if(SPI_TRANSMIT(BMB_SPI_TRANSACTION, &hspi1, SPI_TIMEOUT_MS, txBuffer, rxBuffer, packetLength) != SPI_SUCCESS)
     {
         closePort(port);
         return TRANSACTION_SPI_ERROR;
@@ -309,87 +302,199 @@ static TRANSACTION_STATUS_E writeRegister(uint16_t command, uint32_t numBmbs, ui
     return TRANSACTION_SUCCESS;
 }
 
-static TRANSACTION_STATUS_E readRegister(uint16_t command, uint32_t numBmbs, uint8_t *rxBuff, PORT_E port)
+static TRANSACTION_STATUS_E readRegisterFrame(uint16_t command, uint32_t numBmbs, uint8_t *rxBuff, bool *bmbValid, PORT_E port)
 {
-    // Size in bytes: Command Word(2) + Command CRC(2) + [Register data(6) + Data CRC(2)] * numBmbs
-    uint32_t packetLength = COMMAND_PACKET_LENGTH + (numBmbs * REGISTER_PACKET_LENGTH);
+    // Size in bytes: Command Word(2) + Command CRC(2) + [Register data(6 or 32) + Data CRC(2)] * numBmbs
+    uint32_t registerSize = getRegisterSize(command);
+    uint32_t registerPacketLength = registerSize + CRC_SIZE_BYTES;
+    uint32_t packetLength = COMMAND_PACKET_LENGTH + (numBmbs * registerPacketLength);
 
     // Create transmit and recieve message buffers
     uint8_t txBuffer[packetLength];
     uint8_t rxBuffer[packetLength];
 
-    // Clear tx buffer array
-    memset(txBuffer, 0, packetLength);
-    
-    // Populate the tx buffer with the command word
-    txBuffer[0] = (uint8_t)(command >> BITS_IN_BYTE);
-    txBuffer[1] = (uint8_t)(command);
+    // Populate the tx buffer with the command word and CRC, followed by the zeros clocked out
+    // while the bmbs return their data
+    loadCommandFrame(command, txBuffer);
+    memset(txBuffer + COMMAND_PACKET_LENGTH, 0, packetLength - COMMAND_PACKET_LENGTH);
 
-    // Calculate the CRC on the command word and place the tx buffer
-    uint16_t commandCRC = calculateCommandCrc(txBuffer, COMMAND_SIZE_BYTES);
-    txBuffer[2] = (uint8_t)(commandCRC >> BITS_IN_BYTE);
-    txBuffer[3] = (uint8_t)(commandCRC);
+    openPort(port);
+    if(SPI_TRANSMIT(BMB_SPI_TRANSACTION, &hspi1, SPI_TIMEOUT_MS, txBuffer, rxBuffer, packetLength) != SPI_SUCCESS)
+    {
+        closePort(port);
+        return TRANSACTION_SPI_ERROR;
+    }
+    closePort(port);
 
-    for(int32_t i = 0; i < TRANSACTION_ATTEMPTS; i++)
+    TRANSACTION_STATUS_E readStatus = TRANSACTION_SUCCESS;
+    for(int32_t j = 0; j < numBmbs; j++)
     {
-        openPort(port);
-        if(SPI_TRANSMIT(HAL_SPI_TransmitReceive_IT, &hspi1, SPI_TIMEOUT_MS, txBuffer, rxBuffer, packetLength) != SPI_SUCCESS)
+        // Data is stored in chain order, so the nearest bmb to port B fills the end of the buffers
+        uint32_t bmb = (port == PORTA) ? (j) : (numBmbs - j - 1);
+
+        // Extract the register data for each bmb into a temporary array
+        uint8_t registerData[registerSize];
+        memcpy(registerData, rxBuffer + (COMMAND_PACKET_LENGTH + (j * registerPacketLength)), registerSize);
+
+        // Extract the CRC sent with the corresponding register data
+        uint16_t pec0 = rxBuffer[COMMAND_PACKET_LENGTH + (j * registerPacketLength) + registerSize];
+        uint16_t pec1 = rxBuffer[COMMAND_PACKET_LENGTH + (j * registerPacketLength) + registerSize + 1];
+        uint16_t registerCRC = ((pec0 << BITS_IN_BYTE) | (pec1)) & 0x03FF;
+        uint8_t bmbCommandCounter = (uint8_t)pec0 >> (BITS_IN_BYTE - COMMAND_COUNTER_BITS);
+
+        // If the CRC is correct for the data sent, populate the rx data buffer with the register data
+        // Else, the bmb is left invalid with whatever data it previously held
+        if(calculateDataCrc(registerData, registerSize, bmbCommandCounter) != registerCRC)
         {
-            closePort(port);
-            return TRANSACTION_SPI_ERROR;
+            continue;
         }
-        closePort(port);
 
-        TRANSACTION_STATUS_E readStatus = TRANSACTION_SUCCESS;
-        for(int32_t j = 0; j < numBmbs; j++)
+        if(bmbCommandCounter != chainInfo.localCommandCounter[port])
         {
-            // Extract the register data for each bmb into a temporary array
-            uint8_t registerData[REGISTER_SIZE_BYTES];
-            memcpy(registerData, rxBuffer + (COMMAND_PACKET_LENGTH + (j * REGISTER_PACKET_LENGTH)), REGISTER_SIZE_BYTES);
-
-            // Extract the CRC sent with the corresponding register data
-            uint16_t pec0 = rxBuffer[COMMAND_PACKET_LENGTH + (j * REGISTER_PACKET_LENGTH) + REGISTER_SIZE_BYTES];
-            uint16_t pec1 = rxBuffer[COMMAND_PACKET_LENGTH + (j * REGISTER_PACKET_LENGTH) + REGISTER_SIZE_BYTES + 1];
-            uint16_t registerCRC = ((pec0 << BITS_IN_BYTE) | (pec1)) & 0x03FF;
-            uint8_t bmbCommandCounter = (uint8_t)pec0 >> (BITS_IN_BYTE - COMMAND_COUNTER_BITS);
-
-            // If the CRC is correct for the data sent, populate the rx data buffer with the register data
-            // Else, the data is not populated and defaults to zeros
-            if(calculateDataCrc(registerData, REGISTER_SIZE_BYTES, bmbCommandCounter) != registerCRC)
+            if(bmbCommandCounter == 0)
             {
-                goto retry;
+                readStatus = TRANSACTION_POR_ERROR;
             }
-
-            if(bmbCommandCounter != chainInfo.localCommandCounter[port])
+            else
             {
-                if(bmbCommandCounter == 0)
+                // A bmb ahead of the local count also received the commands sent from the other port,
+                // so the chain reaches further than it was enumerated. Enumerate it again on the next dual transaction
+                if((chainInfo.chainStatus != CHAIN_COMPLETE) && isCommandCounterAhead(bmbCommandCounter, chainInfo.localCommandCounter[port]))
                 {
-                    readStatus = TRANSACTION_POR_ERROR;
+                    dualTransactions = DUAL_TRANSACTIONS_BEFORE_RETRY;
                 }
-                else if(readStatus == TRANSACTION_SUCCESS)
+                if(readStatus == TRANSACTION_SUCCESS)
                 {
                     readStatus = TRANSACTION_COMMAND_COUNTER_ERROR;
                 }
-                
             }
+        }
 
-            if(port == PORTA)
-            {
-                memcpy(rxBuff + (j * REGISTER_SIZE_BYTES), registerData, REGISTER_SIZE_BYTES); 
-            }
-            else if(port == PORTB)
+        memcpy(rxBuff + (bmb * registerSize), registerData, registerSize);
+        bmbValid[bmb] = true;
+    }
+    return readStatus;
+}
+
+static TRANSACTION_STATUS_E readRegisterAttempts(uint16_t command, uint32_t numBmbs, uint8_t *rxBuff, bool *bmbValid, PORT_E port, uint32_t attempts)
+{
+    // Bmbs that already hold valid data are not read again
+    bool localValid[numBmbs];
+    if(bmbValid == NULL)
+    {
+        memset(localValid, 0, sizeof(localValid));
+        bmbValid = localValid;
+    }
+
+    uint32_t registerSize = getRegisterSize(command);
+    TRANSACTION_STATUS_E readStatus = TRANSACTION_SUCCESS;
+    for(int32_t i = 0; i < attempts; i++)
+    {
+        // Find the nearest and furthest bmbs from the port that are missing data
+        int32_t nearestMissing = -1;
+        int32_t furthestMissing = -1;
+        for(int32_t j = 0; j < numBmbs; j++)
+        {
+            uint32_t bmb = (port == PORTA) ? (j) : (numBmbs - j - 1);
+            if(!bmbValid[bmb])
             {
-                memcpy(rxBuff + ((numBmbs - j - 1) * REGISTER_SIZE_BYTES), registerData, REGISTER_SIZE_BYTES); 
+                nearestMissing = (nearestMissing < 0) ? (j) : (nearestMissing);
+                furthestMissing = j;
             }
         }
-        return readStatus;
-        retry:;
+        if(nearestMissing < 0)
+        {
+            break;
+        }
+
+        // Re-read with the shortest frame that covers every missing bmb. A complete chain can also
+        // reach them from the opposite port. Only reads of the whole chain are retried while the
+        // chain is complete, so the opposite port frame never extends past the chain
+        PORT_E readPort = port;
+        uint32_t readBmbs = furthestMissing + 1;
+        if((chainInfo.chainStatus == CHAIN_COMPLETE) && ((numBmbs - nearestMissing) < readBmbs))
+        {
+            readPort = !port;
+            readBmbs = numBmbs - nearestMissing;
+        }
+        uint32_t offset = (readPort == PORTB) ? (numBmbs - readBmbs) : (0);
+
+        TRANSACTION_STATUS_E frameStatus = readRegisterFrame(command, readBmbs, rxBuff + (offset * registerSize), bmbValid + offset, readPort);
+        if(frameStatus == TRANSACTION_SPI_ERROR)
+        {
+            return TRANSACTION_SPI_ERROR;
+        }
+        else if(frameStatus == TRANSACTION_POR_ERROR)
+        {
+            readStatus = TRANSACTION_POR_ERROR;
+        }
+        else if((frameStatus == TRANSACTION_COMMAND_COUNTER_ERROR) && (readStatus == TRANSACTION_SUCCESS))
+        {
+            readStatus = TRANSACTION_COMMAND_COUNTER_ERROR;
+        }
     }
-    return TRANSACTION_CRC_ERROR;
+
+    for(int32_t j = 0; j < numBmbs; j++)
+    {
+        if(!bmbValid[j])
+        {
+            return TRANSACTION_CRC_ERROR;
+        }
+    }
+    return readStatus;
+}
+
+static TRANSACTION_STATUS_E readRegister(uint16_t command, uint32_t numBmbs, uint8_t *rxBuff, bool *bmbValid, PORT_E port)
+{
+    return readRegisterAttempts(command, numBmbs, rxBuff, bmbValid, port, TRANSACTION_ATTEMPTS);
+}
+
+static TRANSACTION_STATUS_E pollCommand(uint16_t command, uint32_t numBmbs, uint8_t *rxBuff, bool *complete, PORT_E port)
+{
+    // Size in bytes: Command Word(2) + Command CRC(2) + Poll status(1)
+    uint32_t packetLength = COMMAND_PACKET_LENGTH + POLL_STATUS_BYTES;
+
+    // Create transmit and recieve message buffers
+    uint8_t txBuffer[packetLength];
+    uint8_t rxBuffer[packetLength];
+
+    // Populate the tx buffer with the command word and CRC, followed by the zero clocked out
+    // while the bmbs return their status
+    loadCommandFrame(command, txBuffer);
+    txBuffer[COMMAND_PACKET_LENGTH] = 0;
+
+    openPort(port);
+    if(SPI_TRANSMIT(BMB_SPI_TRANSACTION, &hspi1, SPI_TIMEOUT_MS, txBuffer, rxBuffer, packetLength) != SPI_SUCCESS)
+    {
+        closePort(port);
+        return TRANSACTION_SPI_ERROR;
+    }
+    closePort(port);
+
+    // Only ever clear the flag, so polls from both ports of a broken chain combine
+    if(rxBuffer[COMMAND_PACKET_LENGTH] != POLL_COMPLETE)
+    {
+        *complete = false;
+    }
+    return TRANSACTION_SUCCESS;
 }
 
-static TRANSACTION_STATUS_E sendAndVerifyCommand(uint16_t command, uint32_t numBmbs, uint8_t* buffer, PORT_E port)
+static TRANSACTION_STATUS_E sendAndVerifyCommand(uint16_t command, uint32_t numBmbs, uint8_t* buffer, bool *bmbValid, PORT_E port)
 {
+#if BMB_DEFER_COMMAND_VERIFY
+    // The command counter is checked by the next read, which resyncs the counters on a mismatch
+    if(sendCommand(command, numBmbs, port) == TRANSACTION_SPI_ERROR)
+    {
+        return TRANSACTION_SPI_ERROR;
+    }
+
+    incCommandCounter(port);
+    if(chainInfo.chainStatus == CHAIN_COMPLETE)
+    {
+        incCommandCounter(!port);
+    }
+    return TRANSACTION_SUCCESS;
+#else
     for(int32_t cmdAttempt = 0; cmdAttempt < TRANSACTION_ATTEMPTS; cmdAttempt++)
     {
         if(sendCommand(command, numBmbs, port) == TRANSACTION_SPI_ERROR)
@@ -406,7 +511,7 @@ static TRANSACTION_STATUS_E sendAndVerifyCommand(uint16_t command, uint32_t numB
         for(int32_t readAttempt = 0; readAttempt < 2; readAttempt++)
         {
             uint8_t rxBuff[REGISTER_SIZE_BYTES * numBmbs];
-            TRANSACTION_STATUS_E readStatus = readRegister(READ_SERIAL_ID_COMMAND, numBmbs, rxBuff, port);
+            TRANSACTION_STATUS_E readStatus = readRegister(READ_SERIAL_ID_COMMAND, numBmbs, rxBuff, NULL, port);
 
             if(readStatus == TRANSACTION_SUCCESS)
             {
@@ -442,9 +547,10 @@ static TRANSACTION_STATUS_E sendAndVerifyCommand(uint16_t command, uint32_t numB
         }      
     }
     return TRANSACTION_COMMAND_COUNTER_ERROR;
+#endif
 }
 
-static TRANSACTION_STATUS_E writeAndVerifyRegister(uint16_t command, uint32_t numBmbs, uint8_t *txBuffer, PORT_E port)
+static TRANSACTION_STATUS_E writeAndVerifyRegister(uint16_t command, uint32_t numBmbs, uint8_t *txBuffer, bool *bmbValid, PORT_E port)
 {
     for(int32_t writeAttempt = 0; writeAttempt < TRANSACTION_ATTEMPTS; writeAttempt++)
     {
@@ -462,20 +568,21 @@ static TRANSACTION_STATUS_E writeAndVerifyRegister(uint16_t command, uint32_t nu
         for(int32_t readAttempt = 0; readAttempt < 2; readAttempt++)
         {
             uint8_t rxBuff[REGISTER_SIZE_BYTES * numBmbs];
-            TRANSACTION_STATUS_E readStatus = readRegister(command + 1, numBmbs, rxBuff, port);
+            TRANSACTION_STATUS_E readStatus = readRegister(getReadbackCommand(command), numBmbs, rxBuff, NULL, port);
 
             if(readStatus == TRANSACTION_SUCCESS)
             {
                 if(readAttempt == 0)
                 {
-                    if(memcmp(rxBuff, txBuffer, REGISTER_SIZE_BYTES * numBmbs))
+                    // Every bmb was sent the same data, so every bmb must read it back
+                    for(int32_t i = 0; i < numBmbs; i++)
                     {
-                        return TRANSACTION_SUCCESS;
+                        if(!isReadbackMatch(command, rxBuff + (i * REGISTER_SIZE_BYTES), txBuffer))
+                        {
+                            return TRANSACTION_WRITE_REJECT;
+                        }
                     }
-                    else
-                    {
-                        return TRANSACTION_WRITE_REJECT;
-                    }  
+                    return TRANSACTION_SUCCESS;
                 }
                 break;
             }
@@ -507,13 +614,13 @@ static TRANSACTION_STATUS_E writeAndVerifyRegister(uint16_t command, uint32_t nu
     return TRANSACTION_COMMAND_COUNTER_ERROR;
 }
 
-static TRANSACTION_STATUS_E sendMessageBmbChain(transactionPtr transaction, uint16_t command, uint32_t numBmbs, uint8_t *dataBuffer)
+static TRANSACTION_STATUS_E sendMessageBmbChain(transactionPtr transaction, uint16_t command, uint32_t numBmbs, uint8_t *dataBuffer, bool *bmbValid)
 {
     for(int32_t i = 0; i < 2; i++)
     {
         if(chainInfo.chainStatus == CHAIN_COMPLETE)
         {
-            TRANSACTION_STATUS_E cmdStatus = transaction(command, numBmbs, dataBuffer, originPort);
+            TRANSACTION_STATUS_E cmdStatus = transaction(command, numBmbs, dataBuffer, bmbValid, originPort);
 
             if(cmdStatus == TRANSACTION_SUCCESS)
             {
@@ -528,9 +635,18 @@ static TRANSACTION_STATUS_E sendMessageBmbChain(transactionPtr transaction, uint
         }
         else
         {
+            // Port B reads fill the end of the rx buffers, since port B reaches the far end of the chain
+            uint8_t *portBBuffer = dataBuffer;
+            bool *portBValid = bmbValid;
+            if(transaction == readRegister)
+            {
+                portBBuffer = dataBuffer + ((numBmbs - chainInfo.availableBmbs[PORTB]) * getRegisterSize(command));
+                portBValid = bmbValid + (numBmbs - chainInfo.availableBmbs[PORTB]);
+            }
+
             // If there are any chain breaks, use both ports to reach as many bmbs as possible
-            TRANSACTION_STATUS_E portAStatus = (chainInfo.availableBmbs[PORTA] > 0) ? (transaction(command, chainInfo.availableBmbs[PORTA], dataBuffer, PORTA)) : (TRANSACTION_SUCCESS);
-            TRANSACTION_STATUS_E portBStatus = (chainInfo.availableBmbs[PORTB] > 0) ? (transaction(command, chainInfo.availableBmbs[PORTB], dataBuffer, PORTB)) : (TRANSACTION_SUCCESS); 
+            TRANSACTION_STATUS_E portAStatus = (chainInfo.availableBmbs[PORTA] > 0) ? (transaction(command, chainInfo.availableBmbs[PORTA], dataBuffer, bmbValid, PORTA)) : (TRANSACTION_SUCCESS);
+            TRANSACTION_STATUS_E portBStatus = (chainInfo.availableBmbs[PORTB] > 0) ? (transaction(command, chainInfo.availableBmbs[PORTB], portBBuffer, portBValid, PORTB)) : (TRANSACTION_SUCCESS); 
 
             if((portAStatus == TRANSACTION_SUCCESS) && (portBStatus == TRANSACTION_SUCCESS))
             {
@@ -578,29 +694,56 @@ static TRANSACTION_STATUS_E sendMessageBmbChain(transactionPtr transaction, uint
     return TRANSACTION_CRC_ERROR;
 }
 
+static TRANSACTION_STATUS_E findAvailableBmbs(PORT_E port, uint32_t maxBmbs, uint8_t *rxBuff)
+{
+    // A read of n bmbs only passes CRC when the first n bmbs from the port are reachable,
+    // so the reachable count can be found by bisection. Try the full range first, since
+    // the expected outcome is that nothing has changed
+    uint32_t reachable = 0;
+    uint32_t unreachable = maxBmbs + 1;
+    uint32_t bmbs = maxBmbs;
+    while((unreachable - reachable) > 1)
+    {
+        TRANSACTION_STATUS_E readStatus = readRegisterAttempts(READ_SERIAL_ID_COMMAND, bmbs, rxBuff, NULL, port, PROBE_ATTEMPTS);
+        if(readStatus == TRANSACTION_SPI_ERROR)
+        {
+            return TRANSACTION_SPI_ERROR;
+        }
+        else if(readStatus == TRANSACTION_CRC_ERROR)
+        {
+            unreachable = bmbs;
+        }
+        else
+        {
+            reachable = bmbs;
+        }
+        bmbs = (reachable + unreachable) / 2;
+    }
+    chainInfo.availableBmbs[port] = reachable;
+    return TRANSACTION_SUCCESS;
+}
+
 static TRANSACTION_STATUS_E enumerateBmbs(uint32_t numBmbs)
 {
     // Create dummy buffer for read command  
     uint8_t rxBuff[numBmbs * REGISTER_SIZE_BYTES];
 
-    // Attempt to read from an increasing number of bmbs from each port
-    // Set availableBmbs to the number of bmbs reachable 
-    for(int32_t port = 0; port < NUM_PORTS; port++)
+    // Find the number of bmbs reachable from port A
+    if(findAvailableBmbs(PORTA, numBmbs, rxBuff) == TRANSACTION_SPI_ERROR)
     {
-        chainInfo.availableBmbs[port] = numBmbs;
-        for(int32_t bmbs = 1; bmbs <= numBmbs; bmbs++)
-        {
-            TRANSACTION_STATUS_E readStatus = readRegister(READ_SERIAL_ID_COMMAND, bmbs, rxBuff, port);
-            if(readStatus == TRANSACTION_CRC_ERROR)
-            {
-                chainInfo.availableBmbs[port] = (bmbs - 1);
-                break;
-            }
-            else if(readStatus == TRANSACTION_SPI_ERROR)
-            {
-                return TRANSACTION_SPI_ERROR;
-            }
-        }
+        return TRANSACTION_SPI_ERROR;
+    }
+
+    // Port B can at most reach the bmbs port A could not, or every bmb when the chain is intact
+    // If port A reaches every bmb, the only link left to test is the one into port B
+    uint32_t maxPortBBmbs = (chainInfo.availableBmbs[PORTA] == numBmbs) ? (1) : (numBmbs - chainInfo.availableBmbs[PORTA]);
+    if(findAvailableBmbs(PORTB, maxPortBBmbs, rxBuff) == TRANSACTION_SPI_ERROR)
+    {
+        return TRANSACTION_SPI_ERROR;
+    }
+    if((chainInfo.availableBmbs[PORTA] == numBmbs) && (chainInfo.availableBmbs[PORTB] > 0))
+    {
+        chainInfo.availableBmbs[PORTB] = numBmbs;
     }
 
     // Determine the COMMS status from the result of portA and portB enumeration
@@ -622,6 +765,30 @@ static TRANSACTION_STATUS_E enumerateBmbs(uint32_t numBmbs)
     return TRANSACTION_SUCCESS;
 }
 
+static TRANSACTION_STATUS_E resyncCommandCounters(uint32_t numBmbs)
+{
+    // A complete chain is reset from one port, otherwise each reachable segment is reset separately
+    for(int32_t port = 0; port < NUM_PORTS; port++)
+    {
+        uint32_t bmbs = (chainInfo.chainStatus == CHAIN_COMPLETE) ? (numBmbs) : (chainInfo.availableBmbs[port]);
+        if(bmbs > 0)
+        {
+            if(sendCommand(RESET_COMMAND_COUNTER_ADDRESS, bmbs, port) == TRANSACTION_SPI_ERROR)
+            {
+                return TRANSACTION_SPI_ERROR;
+            }
+        }
+        resetCommandCounter(port);
+
+        if(chainInfo.chainStatus == CHAIN_COMPLETE)
+        {
+            resetCommandCounter(!port);
+            break;
+        }
+    }
+    return TRANSACTION_SUCCESS;
+}
+
 // /* ==================================================================== */
 // /* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
 // /* ==================================================================== */
@@ -656,15 +823,38 @@ void wakeChain(uint32_t numBmbs)
 
 TRANSACTION_STATUS_E commandAll(uint16_t command, uint32_t numBmbs)
 {
-    return sendMessageBmbChain(sendAndVerifyCommand, command, numBmbs, NULL);
+    return sendMessageBmbChain(sendAndVerifyCommand, command, numBmbs, NULL, NULL);
 }
 
 TRANSACTION_STATUS_E writeAll(uint16_t command, uint32_t numBmbs, uint8_t *txData)
 { 
-    return sendMessageBmbChain(writeAndVerifyRegister, command, numBmbs, txData);
+    return sendMessageBmbChain(writeAndVerifyRegister, command, numBmbs, txData, NULL);
+}
+
+TRANSACTION_STATUS_E pollAll(uint16_t command, uint32_t numBmbs, bool *complete)
+{
+    // Poll commands do not advance the command counter, so there is nothing to verify
+    *complete = true;
+    return sendMessageBmbChain(pollCommand, command, numBmbs, NULL, complete);
 }
 
-TRANSACTION_STATUS_E readAll(uint16_t command, uint32_t numBmbs, uint8_t *rxData)
+TRANSACTION_STATUS_E readAll(uint16_t command, uint32_t numBmbs, uint8_t *rxData, bool *bmbValid)
 { 
-    return sendMessageBmbChain(readRegister, command, numBmbs, rxData);
+    // Every bmb starts out missing data, retries then only re-read the bmbs that are still missing
+    bool localValid[numBmbs];
+    bmbValid = (bmbValid != NULL) ? (bmbValid) : (localValid);
+    memset(bmbValid, 0, numBmbs * sizeof(bool));
+
+    TRANSACTION_STATUS_E readStatus = sendMessageBmbChain(readRegister, command, numBmbs, rxData, bmbValid);
+
+    // The data itself is valid, but a command since the last read was missed or a bmb was reset.
+    // Report it to the caller and bring the counters back in step for the next read
+    if((readStatus == TRANSACTION_COMMAND_COUNTER_ERROR) || (readStatus == TRANSACTION_POR_ERROR))
+    {
+        if(resyncCommandCounters(numBmbs) == TRANSACTION_SPI_ERROR)
+        {
+            return TRANSACTION_SPI_ERROR;
+        }
+    }
+    return readStatus;
 }
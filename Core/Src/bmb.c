@@ -2,16 +2,137 @@
 /* ============================= INCLUDES ============================= */
 /* ==================================================================== */
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 #include "bmb.h"
 #include "adbms6830.h"
+#include "pec.h"
+#include "stm32f4xx_hal.h"
 
 /* ==================================================================== */
 /* ============================= DEFINES ============================== */
 /* ==================================================================== */
 
 #define CMD_START_ADC       0x0360           
+#define CMD_START_ADC_CONTINUOUS    0x03E0
 
+// Runs the redundant S-ADC alongside the C-ADC in the start commands
+#define START_ADC_REDUNDANT     0x0100
+
+// Reads back busy until every bmb has finished its conversion
+#define CMD_POLL_ADC        0x0718
+
+// Freeze and release the result registers
+#define CMD_SNAPSHOT        0x002D
+#define CMD_RELEASE_SNAPSHOT    0x002F
+
+// Snapshot the last results and start the next conversion before reading out, so the conversion
+// runs while the results stream out. Set to 0 to start the next conversion after the readout
+#ifndef BMB_PIPELINED_SCAN
+#define BMB_PIPELINED_SCAN  1
+#endif
+
+// Start the ADCs once in continuous mode so each scan only reads results. Set to 0 to start a
+// single conversion every scan
+#ifndef BMB_CONTINUOUS_CONVERSION
+#define BMB_CONTINUOUS_CONVERSION   1
+#endif
+
+// Results are frozen for the readout whenever a conversion can overwrite them during it
+#define BMB_SNAPSHOT_SCAN   (BMB_PIPELINED_SCAN || BMB_CONTINUOUS_CONVERSION)
+
+// The start commands run the redundant S-ADC alongside the C-ADC. Read its results in the same snapshot with the
+// unaveraged C-ADC results of the same conversion, and compare every cell as they are decoded. Set to 0 to leave
+// the S-ADC results unread
+#ifndef BMB_REDUNDANT_ADC_CHECK
+#define BMB_REDUNDANT_ADC_CHECK     1
+#endif
+
+// Read a single S-ADC register group and its C-ADC group per scan, rotating through groups A-F, so the check adds
+// a third of the bulk readout to each scan and covers every cell once in six scans. Set to 0 to read every group
+// each scan
+#ifndef BMB_REDUNDANT_ADC_ROTATE
+#define BMB_REDUNDANT_ADC_ROTATE    1
+#endif
+
+// Largest difference between the C-ADC and S-ADC results of a healthy cell
+#ifndef BMB_REDUNDANT_ADC_TOLERANCE_MV
+#define BMB_REDUNDANT_ADC_TOLERANCE_MV  25
+#endif
+
+// Read the thermistors of one mux channel every scan. The aux ADC converts them while the cells are read out,
+// then updateBmbThermistors reads them and selects the next channel between scans, so the mux settles while the
+// bmbs convert cells and the scan itself carries no aux traffic beyond the start command
+#ifndef BMB_THERMISTOR_SCAN
+#define BMB_THERMISTOR_SCAN     1
+#endif
+
+// Time the mux outputs take to settle after a channel change. A scan sooner than this skips the thermistors
+#ifndef BMB_THERMISTOR_SETTLING_MS
+#define BMB_THERMISTOR_SETTLING_MS  5
+#endif
+
+// Check every cell tap for an open wire by converting the S-ADC with the pull-down current on the even taps,
+// then on the odd taps, and comparing each result against the C-ADC. The check runs one step per scan while
+// the C-ADC carries on without the S-ADC, and the redundant check pauses until it finishes
+#ifndef BMB_OPEN_WIRE_CHECK
+#define BMB_OPEN_WIRE_CHECK     1
+#endif
+
+// Share of the bus time the open wire check may use. A step waits for a later scan until the budget covers it
+#ifndef BMB_OPEN_WIRE_BUS_PERCENT
+#define BMB_OPEN_WIRE_BUS_PERCENT   2
+#endif
+
+// A pulled down open tap moves the results of the cells either side of it by far more than this
+#ifndef BMB_OPEN_WIRE_THRESHOLD_MV
+#define BMB_OPEN_WIRE_THRESHOLD_MV  400
+#endif
+
+// Read the status register groups in the time left between scans. Each cycle the reads may use this much bus
+// time, and a read that would leave its diagnostic unread for longer than its period runs even if the budget is
+// spent. Every scan leaves the diagnostics a slot, so with a cycle no shorter than the scan period each cycle gets
+// at least one read. The budget must cover a read of the whole accumulator, which at 1 Mbit and 1500 us holds for
+// up to 22 bmbs
+#ifndef BMB_DIAGNOSTIC_CYCLE_MS
+#define BMB_DIAGNOSTIC_CYCLE_MS     50
+#endif
+
+#ifndef BMB_DIAGNOSTIC_BUDGET_US
+#define BMB_DIAGNOSTIC_BUDGET_US    1500
+#endif
+
+// Longest time each diagnostic may go unread
+#ifndef BMB_REFERENCE_PERIOD_MS
+#define BMB_REFERENCE_PERIOD_MS     1000
+#endif
+
+#ifndef BMB_SUPPLY_PERIOD_MS
+#define BMB_SUPPLY_PERIOD_MS        1000
+#endif
+
+#ifndef BMB_FAULT_PERIOD_MS
+#define BMB_FAULT_PERIOD_MS         250
+#endif
+
+// Convert and read the sum of cells result V+ this often, independent of the scan. The conversion covers V+ alone,
+// so the thermistor mux outputs and status results are left to the aux conversion of the scan
+#ifndef BMB_MODULE_VOLTAGE_PERIOD_MS
+#define BMB_MODULE_VOLTAGE_PERIOD_MS    25
+#endif
+
+// A bmb's sum of cells result may differ from the sum of its cell voltages by this much before it is flagged.
+// Covers the V+ measurement error and the cells moving between the two conversions
+#ifndef BMB_SUM_OF_CELLS_TOLERANCE_MV
+#define BMB_SUM_OF_CELLS_TOLERANCE_MV   300
+#endif
+
+// SPI1 runs at 64 MHz / 64
+#ifndef BMB_BUS_BIT_RATE_HZ
+#define BMB_BUS_BIT_RATE_HZ     1000000
+#endif
+
+// Averaged C-ADC cell voltage register groups A-F
 #define READ_VOLT_REG_A     0x0044
 #define READ_VOLT_REG_B     0x0046
 #define READ_VOLT_REG_C     0x0048
@@ -20,121 +141,1479 @@
 #define READ_VOLT_REG_F     0x004B
 #define NUM_VOLT_REG        6
 
+// Reads voltage registers A-F from each bmb in a single packet
+#define READ_VOLT_REG_ALL   0x004C
+
+// Unaveraged C-ADC cell voltage register groups
+#define READ_CADC_REG_A     0x0004
+#define READ_CADC_REG_B     0x0006
+#define READ_CADC_REG_C     0x0008
+#define READ_CADC_REG_D     0x000A
+#define READ_CADC_REG_E     0x0009
+#define READ_CADC_REG_F     0x000B
+#define READ_CADC_REG_ALL   0x000C
+
+// Redundant S-ADC cell voltage register groups
+#define READ_SADC_REG_A     0x0003
+#define READ_SADC_REG_B     0x0005
+#define READ_SADC_REG_C     0x0007
+#define READ_SADC_REG_D     0x000D
+#define READ_SADC_REG_E     0x000E
+#define READ_SADC_REG_F     0x000F
+#define READ_SADC_REG_ALL   0x0010
+
+// Filtered C-ADC cell voltage register groups
+#define READ_FILT_REG_A     0x0012
+#define READ_FILT_REG_B     0x0013
+#define READ_FILT_REG_C     0x0014
+#define READ_FILT_REG_D     0x0015
+#define READ_FILT_REG_E     0x0016
+#define READ_FILT_REG_F     0x0017
+#define READ_FILT_REG_ALL   0x0018
+
+// Aux register groups A-C hold GPIO 1-9, group D holds GPIO 10, VMV and V+
+#define READ_AUX_REG_A      0x0019
+#define READ_AUX_REG_B      0x001A
+#define READ_AUX_REG_C      0x001B
+#define READ_AUX_REG_D      0x001F
+
+// Status group A holds VREF2 and the die temperature, group B holds VD, VA and VRES
+#define READ_STATUS_REG_A   0x0030
+#define READ_STATUS_REG_B   0x0031
+#define READ_STATUS_REG_C   0x0032
+
+// Converts every GPIO and the module voltages, and reads back busy until every bmb has finished
+#define CMD_START_AUX_ADC   0x0410
+
+// Converts V+ alone, CH[4:0] = 1 0100 with CH4 in bit 6
+#define CMD_START_VPV_ADC   0x0454
+#define CMD_POLL_AUX_ADC    0x071E
+
+// S-ADC conversion of every cell, 0 0 1 CONT 1 1 DCP 1 0 OW[1:0], with OW pulling down the even or odd cell taps
+#define CMD_START_SADC      0x0168
+#define SADC_OPEN_WIRE_EVEN 0x0001
+#define SADC_OPEN_WIRE_ODD  0x0002
+#define CMD_POLL_SADC       0x071D
+
+// Config register group A holds the GPO outputs. Every GPO is left high, so no GPIO is pulled down, apart from
+// GPO 9-10 which select the mux channel. The other fields keep their reset values
+#define WRITE_CONFIG_REG_A  0x0001
+#define READ_CONFIG_REG_A   0x0002
+#define CONFIG_A_RESET_0    0x01
+#define CONFIG_A_GPO_1_8    0xFF
+
+// Cell voltage comparator thresholds live in config register group B and the comparator flags in status register group D
+#define WRITE_CONFIG_REG_B  0x0024
+#define READ_STATUS_REG_D   0x0033
+#define CMD_CLEAR_CELL_FLAGS    0x0715
+
 #define CELLS_PER_REG       3
-#define CELL_REG_SIZE       REGISTER_SIZE_BYTES / CELLS_PER_REG
 
-#define ADC_RESOLUTION_BITS     16
-#define MAX_ADC_READING         0xFFFF
+// Registers A-E hold 3 cells each, register F holds the final cell
+#define NUM_CELLS_IN_VOLT_REG   (((NUM_VOLT_REG - 1) * CELLS_PER_REG) + 1)
+
+// A cell row holds exactly the cells the voltage registers return, so a bmb with every cell good has ALL_CELLS_MASK
+#if NUM_CELLS_PER_BMB != NUM_CELLS_IN_VOLT_REG
+#error "NUM_CELLS_PER_BMB must match the cells in the voltage registers"
+#endif
+
 #define ADC_RESOLUTION          0.00015f
 #define ADC_OFFSET              1.5f
 
+// VMV and V+ are divided by 25 before conversion
+#define MODULE_VOLTAGE_SCALE    25.0f
+#define MODULE_VOLTAGE_SCALE_CODES  25
+
+// ADC_OFFSET in codes, so sums of codes can be compared with the offset of every code added back
+#define ADC_OFFSET_CODES        10000
+
+// The die temperature sensor reads 7.5mV per kelvin
+#define ITMP_RESOLUTION         (ADC_RESOLUTION / 0.0075f)
+#define ITMP_OFFSET             ((ADC_OFFSET / 0.0075f) - 273.0f)
+
+// Codes this close to either end of the signed 16-bit range are railed
 #define RAILED_MARGIN_BITS  2500
 
 #define TEST_REG    0x002C
 
+// Comparator thresholds are 12-bit codes compared with the top 12 bits of each C-ADC result
+#define CELL_THRESHOLD_SHIFT    4
+#define CELL_THRESHOLD_MIN      (-2048)
+#define CELL_THRESHOLD_MAX      2047
+#define CELL_THRESHOLD_MASK     0x0FFF
+
+#define ALL_CELLS_MASK          ((1UL << NUM_CELLS_PER_BMB) - 1)
+
+// Status group C holds the fault flags in bytes 4 and 5
+#define STATUS_C_FAULT_BYTE     4
+#define ALL_FAULTS_MASK         0xFFFFUL
+
+// One ADC code is 150uV
+#define REDUNDANT_ADC_TOLERANCE     ((BMB_REDUNDANT_ADC_TOLERANCE_MV * 1000) / 150)
+#define OPEN_WIRE_THRESHOLD         ((BMB_OPEN_WIRE_THRESHOLD_MV * 1000) / 150)
+#define SUM_OF_CELLS_TOLERANCE      ((BMB_SUM_OF_CELLS_TOLERANCE_MV * 1000) / 150)
+
+// Estimated bus time of each transaction, from its length and the time chip select is held around the frame.
+// A poll clocks out one status byte after the command
+#define BUS_FRAME_OVERHEAD_US       2
+#define BUS_BYTE_TIME_US            ((BITS_IN_BYTE * 1000000UL) / BMB_BUS_BIT_RATE_HZ)
+#define COMMAND_BUS_TIME_US         (BUS_FRAME_OVERHEAD_US + (COMMAND_PACKET_LENGTH * BUS_BYTE_TIME_US))
+#define POLL_BUS_TIME_US            (COMMAND_BUS_TIME_US + BUS_BYTE_TIME_US)
+#define READ_BUS_TIME_US(numBmbs)   (COMMAND_BUS_TIME_US + ((numBmbs) * (REGISTER_SIZE_BYTES + CRC_SIZE_BYTES) * BUS_BYTE_TIME_US))
+
+// The open wire budget gains this much bus time per ms, and never holds more than its costliest step, a read
+// with its poll and the restart ending the check
+#define OPEN_WIRE_BUDGET_US_PER_MS  (BMB_OPEN_WIRE_BUS_PERCENT * 10)
+#define OPEN_WIRE_MAX_STEP_US(numBmbs)  ((2 * READ_BUS_TIME_US(numBmbs)) + POLL_BUS_TIME_US + COMMAND_BUS_TIME_US)
+
+// Redundant reads between open wire checks, so every cell is checked against the S-ADC before it is taken again
+#if BMB_REDUNDANT_ADC_CHECK && BMB_REDUNDANT_ADC_ROTATE
+#define OPEN_WIRE_SPACING_READS     NUM_VOLT_REG
+#elif BMB_REDUNDANT_ADC_CHECK
+#define OPEN_WIRE_SPACING_READS     1
+#else
+#define OPEN_WIRE_SPACING_READS     0
+#endif
+
+// A diagnostic may run from half its period on, which leaves it half a period of cycles to find budget in
+#define DIAGNOSTIC_EARLIEST_MS(period)  ((period) / 2)
+
+#if READ_BUS_TIME_US(NUM_BMBS_IN_ACCUMULATOR) > BMB_DIAGNOSTIC_BUDGET_US
+#error "The diagnostic budget must cover a register group read of every bmb in the accumulator"
+#endif
+
+#if (BMB_FAULT_PERIOD_MS < (2 * BMB_DIAGNOSTIC_CYCLE_MS)) || (BMB_REFERENCE_PERIOD_MS < (2 * BMB_DIAGNOSTIC_CYCLE_MS)) || (BMB_SUPPLY_PERIOD_MS < (2 * BMB_DIAGNOSTIC_CYCLE_MS))
+#error "Diagnostic periods must span at least two budget cycles"
+#endif
+
+// Result registers read back this value from reset until the first conversion completes
+#define ADC_CLEARED_RESULT  0x8000
+
+// Copies a run of results into the named pack telemetry array and its matching validity masks
+#define REGISTER_MAP(cmd, field, count, dest, index, railed) \
+    REGISTER_MAP_HOOKS(cmd, field, count, dest, index, railed, REGISTER_HOOK_NONE)
+
+// As REGISTER_MAP, with the REGISTER_HOOK_ flags of the work done on the results once they are decoded
+#define REGISTER_MAP_HOOKS(cmd, field, count, dest, index, railed, hooks) \
+    { (cmd), (field), (count), (index), (railed), (hooks), MEASUREMENTS_PER_BMB(dest), \
+      offsetof(PackTelemetry_S, dest), offsetof(PackTelemetry_S, dest##Valid) }
+
+// Work done on a run of results once they are decoded
+#define REGISTER_HOOK_NONE              0x00
+#define REGISTER_HOOK_ACCUMULATE_STATS  0x01    // Add the good results to the running pack statistics
+#define REGISTER_HOOK_COMPARE_REDUNDANT 0x02    // Check S-ADC results against the decoded C-ADC results
+
+// Entries each bmb has in a pack telemetry array
+#define MEASUREMENTS_PER_BMB(dest)  (sizeof(((PackTelemetry_S *)0)->dest[0]) / sizeof(int16_t))
+
+// The bulk read and register groups A-F of a cell voltage result
+#define CELL_REGISTER_MAP(all, a, b, c, d, e, f, dest, hooks) \
+    REGISTER_MAP_HOOKS(all, 0, NUM_CELLS_IN_VOLT_REG, dest, 0, true, hooks), \
+    REGISTER_MAP_HOOKS(a, 0, CELLS_PER_REG, dest, 0, true, hooks), \
+    REGISTER_MAP_HOOKS(b, 0, CELLS_PER_REG, dest, 3, true, hooks), \
+    REGISTER_MAP_HOOKS(c, 0, CELLS_PER_REG, dest, 6, true, hooks), \
+    REGISTER_MAP_HOOKS(d, 0, CELLS_PER_REG, dest, 9, true, hooks), \
+    REGISTER_MAP_HOOKS(e, 0, CELLS_PER_REG, dest, 12, true, hooks), \
+    REGISTER_MAP_HOOKS(f, 0, 1, dest, 15, true, hooks)
+
+/* ==================================================================== */
+/* ========================= ENUMERATED TYPES========================== */
+/* ==================================================================== */
+
+// Steps of an open wire check, at most one of which runs per scan
+typedef enum
+{
+    OPEN_WIRE_IDLE = 0,     // Waiting to take the S-ADC for the next check
+    OPEN_WIRE_CONVERT,      // Start the S-ADC with one polarity of pull-down
+    OPEN_WIRE_READ          // Read the results, one register group per step
+} OPEN_WIRE_STEP_E;
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+// A run of consecutive 16-bit results in a register group and where they are stored in PackTelemetry_S
+typedef struct
+{
+    uint16_t command;       // Read command of the register group
+    uint8_t firstField;     // First result in the register data
+    uint8_t numFields;      // Number of consecutive results
+    uint8_t firstIndex;     // Destination index of the first result
+    bool checkRailed;       // Mark results near either rail as bad
+    uint8_t hooks;          // REGISTER_HOOK_ flags of the work done on the decoded results
+    uint8_t stride;         // Entries each bmb has in the destination array
+    uint32_t codeOffset;    // Offset of the destination code array
+    uint32_t validOffset;   // Offset of the destination validity mask array
+} RegisterMap_S;
+
+// A register group read by the diagnostic scheduler
+typedef struct
+{
+    uint16_t command;       // Read command of the register group
+    uint32_t periodMs;      // Longest time the group may go unread
+    bool auxConverted;      // Results come from the aux conversion
+} Diagnostic_S;
+
 /* ==================================================================== */
 /* ========================= LOCAL VARIABLES ========================== */
 /* ==================================================================== */
 
-uint16_t readVoltReg[NUM_VOLT_REG] =
+// Cleared whenever a bmb may have lost its continuous conversions, so they are restarted
+static bool conversionsRunning = false;
+
+// Continuous conversions keep the results valid once the first one after a start has finished
+static bool conversionsComplete = false;
+
+// Set when a bmb missed a command, which may have been the release ending the last snapshot
+static bool commandMissed = false;
+
+// Pack statistics of the scan in progress, readable through getBmbScanStats and published once every cell has
+// been decoded
+static PackStatsAccumulator_S scanStats;
+
+// Config register group B holding the cell voltage limits, which a reset bmb loses
+static uint8_t cellLimitConfig[REGISTER_SIZE_BYTES];
+static bool cellLimitsSet = false;
+static bool cellLimitsWritten = false;
+
+#if BMB_THERMISTOR_SCAN
+// Mux channel selected on every bmb and when, and whether its aux conversion is in flight. The selection is
+// dropped whenever a bmb may have been reset back to its default channel
+static uint32_t thermistorChannel = 0;
+static uint32_t thermistorSelectTick = 0;
+static bool thermistorSelected = false;
+static bool thermistorConversionStarted = false;
+static bool thermistorReadoutDue = false;
+#endif
+
+static const uint16_t readVoltReg[NUM_VOLT_REG] =
 {
     READ_VOLT_REG_A, READ_VOLT_REG_B,
     READ_VOLT_REG_C, READ_VOLT_REG_D,
     READ_VOLT_REG_E, READ_VOLT_REG_F,
 };
 
+#if (BMB_REDUNDANT_ADC_CHECK && BMB_REDUNDANT_ADC_ROTATE) || BMB_OPEN_WIRE_CHECK
+static const uint16_t readSAdcReg[NUM_VOLT_REG] =
+{
+    READ_SADC_REG_A, READ_SADC_REG_B,
+    READ_SADC_REG_C, READ_SADC_REG_D,
+    READ_SADC_REG_E, READ_SADC_REG_F,
+};
+#endif
+
+#if (BMB_REDUNDANT_ADC_CHECK && BMB_REDUNDANT_ADC_ROTATE) || BMB_OPEN_WIRE_CHECK
+static const uint16_t readCAdcReg[NUM_VOLT_REG] =
+{
+    READ_CADC_REG_A, READ_CADC_REG_B,
+    READ_CADC_REG_C, READ_CADC_REG_D,
+    READ_CADC_REG_E, READ_CADC_REG_F,
+};
+#endif
+
+#if BMB_REDUNDANT_ADC_CHECK && BMB_REDUNDANT_ADC_ROTATE
+// Register group read by the next scan
+static uint32_t redundantGroup = 0;
+#endif
+
+// Whether the last start command ran the S-ADC alongside the C-ADC, and whether the conversion read by this
+// scan did. Only then do both ADCs hold results of the same conversion
+static bool redundantStarted = false;
+static bool redundantReady = false;
+
+#if BMB_OPEN_WIRE_CHECK
+// The S-ADC register groups decode into the open wire results while a check holds the S-ADC. Railed results
+// are kept, since an open tap can pull a cell to either rail
+static const RegisterMap_S openWireRegisterMap[NUM_VOLT_REG] =
+{
+    REGISTER_MAP(READ_SADC_REG_A, 0, CELLS_PER_REG, openWireVoltage, 0, false),
+    REGISTER_MAP(READ_SADC_REG_B, 0, CELLS_PER_REG, openWireVoltage, 3, false),
+    REGISTER_MAP(READ_SADC_REG_C, 0, CELLS_PER_REG, openWireVoltage, 6, false),
+    REGISTER_MAP(READ_SADC_REG_D, 0, CELLS_PER_REG, openWireVoltage, 9, false),
+    REGISTER_MAP(READ_SADC_REG_E, 0, CELLS_PER_REG, openWireVoltage, 12, false),
+    REGISTER_MAP(READ_SADC_REG_F, 0, 1, openWireVoltage, 15, false),
+};
+
+// Progress of the running check. The S-ADC is held from the first step until the check goes back to idle
+static OPEN_WIRE_STEP_E openWireStep = OPEN_WIRE_IDLE;
+static uint16_t openWirePolarity = SADC_OPEN_WIRE_EVEN;
+static uint32_t openWireGroup = 0;
+static bool openWirePolled = false;
+
+// Bus time in us the check may still use, and when it was last topped up
+static uint32_t openWireBudgetUs = 0;
+static uint32_t openWireBudgetTick = 0;
+
+// Redundant reads since the last check ended
+static uint32_t redundantReadsSinceOpenWire = 0;
+
+// Cells of each bmb found open and cells checked in every polarity so far, published once a group has both
+static uint32_t openWireFound[NUM_BMBS_IN_ACCUMULATOR];
+static uint32_t openWireChecked[NUM_BMBS_IN_ACCUMULATOR];
+#endif
+
+static const Diagnostic_S diagnostics[NUM_DIAGNOSTICS] =
+{
+    [DIAGNOSTIC_REFERENCES] = { READ_STATUS_REG_A, BMB_REFERENCE_PERIOD_MS, true },
+    [DIAGNOSTIC_SUPPLIES] = { READ_STATUS_REG_B, BMB_SUPPLY_PERIOD_MS, true },
+    [DIAGNOSTIC_FAULTS] = { READ_STATUS_REG_C, BMB_FAULT_PERIOD_MS, false },
+};
+
+// When each diagnostic last ran, and the start of the budget cycle and the bus time used in it so far
+static uint32_t diagnosticTick[NUM_DIAGNOSTICS];
+static uint32_t diagnosticCycleTick = 0;
+static uint32_t diagnosticBusTimeUs = 0;
+static bool diagnosticsStarted = false;
+
+// When the last sum of cells conversion was started, and whether it is still to be read
+static uint32_t moduleVoltageTick = 0;
+static bool moduleVoltageConversionStarted = false;
+
+// Entries sharing a command must be adjacent
+static const RegisterMap_S registerMap[] =
+{
+    CELL_REGISTER_MAP(READ_VOLT_REG_ALL, READ_VOLT_REG_A, READ_VOLT_REG_B, READ_VOLT_REG_C,
+                      READ_VOLT_REG_D, READ_VOLT_REG_E, READ_VOLT_REG_F, cellVoltage, REGISTER_HOOK_ACCUMULATE_STATS),
+    CELL_REGISTER_MAP(READ_CADC_REG_ALL, READ_CADC_REG_A, READ_CADC_REG_B, READ_CADC_REG_C,
+                      READ_CADC_REG_D, READ_CADC_REG_E, READ_CADC_REG_F, cAdcVoltage, REGISTER_HOOK_NONE),
+    CELL_REGISTER_MAP(READ_SADC_REG_ALL, READ_SADC_REG_A, READ_SADC_REG_B, READ_SADC_REG_C,
+                      READ_SADC_REG_D, READ_SADC_REG_E, READ_SADC_REG_F, sAdcVoltage, REGISTER_HOOK_COMPARE_REDUNDANT),
+    CELL_REGISTER_MAP(READ_FILT_REG_ALL, READ_FILT_REG_A, READ_FILT_REG_B, READ_FILT_REG_C,
+                      READ_FILT_REG_D, READ_FILT_REG_E, READ_FILT_REG_F, filteredCellVoltage, REGISTER_HOOK_NONE),
+    REGISTER_MAP(READ_AUX_REG_A, 0, 3, gpioVoltage, 0, false),
+    REGISTER_MAP(READ_AUX_REG_B, 0, 3, gpioVoltage, 3, false),
+    REGISTER_MAP(READ_AUX_REG_C, 0, 3, gpioVoltage, 6, false),
+    REGISTER_MAP(READ_AUX_REG_D, 0, 1, gpioVoltage, 9, false),
+    REGISTER_MAP(READ_AUX_REG_D, 1, NUM_MODULE_VOLTAGES, moduleVoltage, MODULE_VOLTAGE_VMV, false),
+    REGISTER_MAP(READ_STATUS_REG_A, 0, 2, statusResult, STATUS_RESULT_VREF2, false),
+    REGISTER_MAP(READ_STATUS_REG_B, 0, 3, statusResult, STATUS_RESULT_VD, false),
+};
+
+#define NUM_REGISTER_MAPS   (sizeof(registerMap) / sizeof(registerMap[0]))
+
 /* ==================================================================== */
 /* =================== LOCAL FUNCTION DECLARATIONS ==================== */
 /* ==================================================================== */
 
-static bool isAdcRailed(uint16_t rawAdc);
+static bool isAdcRailed(int16_t code);
+static const RegisterMap_S* findRegisterMap(uint16_t command, uint32_t *numMaps);
+static bool decodeRegisterMap(PackTelemetry_S *pack, PackStatsAccumulator_S *scanStats, uint32_t bmb, const RegisterMap_S *map, uint32_t numMaps, const uint8_t *registerData);
+static void invalidateRegisterMap(PackTelemetry_S *pack, uint32_t bmb, const RegisterMap_S *map, uint32_t numMaps);
+static void readCellVoltagesPerRegister(PackTelemetry_S *pack, PackStatsAccumulator_S *scanStats, uint32_t numBmbs, bool *bulkValid);
+static uint32_t compareRedundantResults(const int16_t *cAdc, const int16_t *sAdc, uint32_t numFields, int32_t tolerance);
+#if BMB_REDUNDANT_ADC_CHECK || BMB_OPEN_WIRE_CHECK
+static void readResultGroup(PackTelemetry_S *pack, uint16_t command, uint32_t registerSize, uint32_t numBmbs);
+#endif
+#if BMB_REDUNDANT_ADC_CHECK
+static void readRedundantVoltages(PackTelemetry_S *pack, uint32_t numBmbs);
+#endif
+static TRANSACTION_STATUS_E startCellConversions(uint16_t command, uint32_t numBmbs);
+#if BMB_OPEN_WIRE_CHECK
+static uint32_t getOpenWireStepCost(uint32_t numBmbs);
+static void readOpenWireGroup(PackTelemetry_S *pack, uint32_t numBmbs);
+static void runOpenWireStep(PackTelemetry_S *pack, uint32_t numBmbs);
+#endif
+static void trackConversionState(TRANSACTION_STATUS_E status);
+static void handleBmbReset(void);
+#if BMB_THERMISTOR_SCAN
+static void startThermistorConversion(uint32_t numBmbs);
+static void readThermistorChannel(PackTelemetry_S *pack, uint32_t numBmbs);
+static void convertThermistor(PackTelemetry_S *pack, uint32_t bmb, uint32_t thermistor);
+static bool updateThermistors(PackTelemetry_S *pack, uint32_t numBmbs);
+#endif
+static uint32_t getDiagnosticCost(DIAGNOSTIC_E diagnostic, uint32_t numBmbs);
+static void runDiagnostic(PackTelemetry_S *pack, DIAGNOSTIC_E diagnostic, uint32_t numBmbs);
+static void readModuleVoltages(PackTelemetry_S *pack, uint32_t numBmbs);
+static void checkSumOfCells(PackTelemetry_S *pack, uint32_t numBmbs);
+
+static int32_t voltsToCellThreshold(float volts);
+static uint32_t compactEvenBits(uint32_t bits);
 
 /* ==================================================================== */
 /* =================== LOCAL FUNCTION DEFINITIONS ===================== */
 /* ==================================================================== */
 
 /*!
-  @brief   Check if a 14-bit ADC sensor value is railed (near minimum or maximum).
-  @param   rawAdcVal - The raw 14-bit ADC sensor value to check.
-  @return  True if the sensor value is within the margin of railed values, false otherwise.
+  @brief   Check if a signed 16-bit ADC code is railed (near the minimum or maximum code).
+  @param   code - The ADC code to check.
+  @return  True if the code is within the margin of either rail, false otherwise.
 */
-static bool isAdcRailed(uint16_t rawAdc)
+static bool isAdcRailed(int16_t code)
 {
-	// Determine if the adc reading is within a margin of the railed values
-    return ((rawAdc < RAILED_MARGIN_BITS) || (rawAdc > (MAX_ADC_READING - RAILED_MARGIN_BITS)));
+    // Codes are signed around the 1.5 V offset, so the rails are the ends of the int16_t range
+    return ((code < (INT16_MIN + RAILED_MARGIN_BITS)) || (code > (INT16_MAX - RAILED_MARGIN_BITS)));
 }
 
-/* ==================================================================== */
-/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
-/* ==================================================================== */
+/*!
+  @brief   Find the register map entries that decode a register group.
+  @param   command - Read command of the register group.
+  @param   numMaps - Set to the number of entries found.
+  @return  The first entry for the command, or NULL if the group is not mapped.
+*/
+static const RegisterMap_S* findRegisterMap(uint16_t command, uint32_t *numMaps)
+{
+    // A group is decoded for every bmb in the chain in turn, so the last lookup is usually the one needed
+    static const RegisterMap_S *lastMap = NULL;
+    static uint32_t lastNumMaps = 0;
+    if((lastMap != NULL) && (lastMap->command == command))
+    {
+        *numMaps = lastNumMaps;
+        return lastMap;
+    }
+
+    for(uint32_t i = 0; i < NUM_REGISTER_MAPS; i++)
+    {
+        if(registerMap[i].command == command)
+        {
+            uint32_t end = i + 1;
+            while((end < NUM_REGISTER_MAPS) && (registerMap[end].command == command))
+            {
+                end++;
+            }
+            lastMap = &registerMap[i];
+            lastNumMaps = end - i;
+            *numMaps = lastNumMaps;
+            return lastMap;
+        }
+    }
 
-void updateBmbTelemetry(Bmb_S* bmb, uint32_t numBmbs)
+    *numMaps = 0;
+    return NULL;
+}
+
+/*!
+  @brief   Store the raw results of a register group and update their validity.
+  @param   pack - Pack telemetry to update.
+  @param   scanStats - Running pack statistics, updated with any good averaged cell voltages. May be NULL.
+  @param   bmb - Index of the bmb in the chain.
+  @param   map - Register map entries of the group.
+  @param   numMaps - Number of register map entries.
+  @param   registerData - The bmb's register data.
+  @return  False if any result was still cleared.
+*/
+static bool decodeRegisterMap(PackTelemetry_S *pack, PackStatsAccumulator_S *scanStats, uint32_t bmb, const RegisterMap_S *map, uint32_t numMaps, const uint8_t *registerData)
 {
-    // TODO add polling to check scan status - prevent initialization error 
+    bool converted = true;
+    for(uint32_t i = 0; i < numMaps; i++)
+    {
+        // Copied out of the entry, since stores through the destination pointers could otherwise alias it
+        const uint32_t numFields = map[i].numFields;
+        const uint32_t firstIndex = map[i].firstIndex;
+        const bool checkRailed = map[i].checkRailed;
+        const uint32_t hooks = map[i].hooks;
+        int16_t *code = (int16_t *)((uint8_t *)pack + map[i].codeOffset) + (bmb * map[i].stride) + firstIndex;
+        uint32_t *valid = (uint32_t *)((uint8_t *)pack + map[i].validOffset) + bmb;
+        const uint8_t *field = registerData + (map[i].firstField * BYTES_IN_WORD);
+
+        // Codes are stored whether or not they are good, only the validity mask depends on them
+        uint32_t goodMask = 0;
+        for(uint32_t j = 0; j < numFields; j++)
+        {
+            uint16_t rawAdcLSB = field[j * BYTES_IN_WORD];
+            uint16_t rawAdcMSB = field[(j * BYTES_IN_WORD) + 1];
+            uint16_t rawAdc = (rawAdcMSB << BITS_IN_BYTE) | (rawAdcLSB);
+            bool cleared = (rawAdc == ADC_CLEARED_RESULT);
+            bool good = !cleared && !(checkRailed && isAdcRailed((int16_t)rawAdc));
 
-    for(int32_t i = 0; i < NUM_VOLT_REG-1; i++)
+            code[j] = (int16_t)rawAdc;
+            goodMask |= (uint32_t)good << j;
+            converted &= !cleared;
+        }
+
+        uint32_t fieldMask = ((1UL << numFields) - 1) << firstIndex;
+        *valid = (*valid & ~fieldMask) | (goodMask << firstIndex);
+
+        // Statistics are accumulated while the codes are still in cache
+        if((scanStats != NULL) && (hooks & REGISTER_HOOK_ACCUMULATE_STATS))
+        {
+            accumulatePackStats(scanStats, bmb, code - firstIndex, goodMask << firstIndex);
+        }
+
+        // S-ADC results are checked against the unaveraged C-ADC results of the same group, which are read and
+        // decoded just before them. The averaged results would lag a transient the S-ADC sees
+        if(hooks & REGISTER_HOOK_COMPARE_REDUNDANT)
+        {
+            uint32_t compared = pack->cAdcVoltageValid[bmb] & (goodMask << firstIndex);
+            uint32_t differ = compareRedundantResults(pack->cAdcVoltage[bmb] + firstIndex, code, numFields, REDUNDANT_ADC_TOLERANCE) << firstIndex;
+            pack->redundantAdcMismatch[bmb] = (pack->redundantAdcMismatch[bmb] & ~fieldMask) | (differ & compared);
+        }
+    }
+
+    return converted;
+}
+
+/*!
+  @brief   Mark every measurement of a register group that could not be read as bad.
+  @param   pack - Pack telemetry to update.
+  @param   bmb - Index of the bmb in the chain.
+  @param   map - Register map entries of the group.
+  @param   numMaps - Number of register map entries.
+*/
+static void invalidateRegisterMap(PackTelemetry_S *pack, uint32_t bmb, const RegisterMap_S *map, uint32_t numMaps)
+{
+    for(uint32_t i = 0; i < numMaps; i++)
     {
-        uint8_t registerData[REGISTER_SIZE_BYTES];
-        memset(registerData, 0, REGISTER_SIZE_BYTES);
-        readAll(readVoltReg[i], numBmbs, registerData);
-        for(int32_t j = 0; j < CELLS_PER_REG; j++)
+        uint32_t *valid = (uint32_t *)((uint8_t *)pack + map[i].validOffset) + bmb;
+        *valid &= ~(((1UL << map[i].numFields) - 1) << map[i].firstIndex);
+    }
+}
+
+/*!
+  @brief   Find the cells whose C-ADC and S-ADC results differ by more than a tolerance.
+  @param   cAdc - C-ADC results of a run of cells.
+  @param   sAdc - S-ADC results of the same cells.
+  @param   numFields - Number of cells in the run.
+  @param   tolerance - Largest difference in ADC codes that is not flagged.
+  @return  Bit n is set when cell n of the run differs.
+*/
+static uint32_t compareRedundantResults(const int16_t *cAdc, const int16_t *sAdc, uint32_t numFields, int32_t tolerance)
+{
+    // Branch free, so the loop pipelines: shifting the difference by the tolerance folds both
+    // comparisons of |d| > tolerance into a single unsigned compare
+    uint32_t differ = 0;
+    for(uint32_t j = 0; j < numFields; j++)
+    {
+        uint32_t shifted = (uint32_t)((int32_t)cAdc[j] - (int32_t)sAdc[j] + tolerance);
+        differ |= (uint32_t)(shifted > (uint32_t)(2 * tolerance)) << j;
+    }
+    return differ;
+}
+
+/*!
+  @brief   Read the cell voltages one register group at a time. Used for bmbs missing from a bulk read.
+  @param   pack - Pack telemetry to update.
+  @param   scanStats - Running pack statistics of the scan.
+  @param   numBmbs - Number of bmbs in the chain.
+  @param   bulkValid - Bmbs already decoded from the bulk read, which are left untouched.
+*/
+static void readCellVoltagesPerRegister(PackTelemetry_S *pack, PackStatsAccumulator_S *scanStats, uint32_t numBmbs, bool *bulkValid)
+{
+    for(int32_t i = 0; i < NUM_VOLT_REG; i++)
+    {
+        uint8_t registerData[REGISTER_SIZE_BYTES * numBmbs];
+        bool registerValid[numBmbs];
+        trackConversionState(readAll(readVoltReg[i], numBmbs, registerData, registerValid));
+
+        uint32_t numMaps;
+        const RegisterMap_S *map = findRegisterMap(readVoltReg[i], &numMaps);
+        for(int32_t k = 0; k < numBmbs; k++)
         {
-            for(int32_t k = 0; k < numBmbs; k++)
+            if(bulkValid[k])
             {
-                uint16_t rawAdcLSB = registerData[(k * REGISTER_SIZE_BYTES) + (j * CELL_REG_SIZE)];
-                uint16_t rawAdcMSB = registerData[(k * REGISTER_SIZE_BYTES) + (j * CELL_REG_SIZE) + 1];
-                uint16_t rawAdc = (rawAdcMSB << BITS_IN_BYTE) | (rawAdcLSB);
-                if(isAdcRailed(rawAdc))
-                {
-                    bmb[k].cellVoltageStatus[(i * CELLS_PER_REG) + j] = BAD;
-                }
-                else
+                continue;
+            }
+
+            if(!registerValid[k])
+            {
+                invalidateRegisterMap(pack, k, map, numMaps);
+            }
+            else if(!decodeRegisterMap(pack, scanStats, k, map, numMaps, registerData + (k * REGISTER_SIZE_BYTES)))
+            {
+                handleBmbReset();
+            }
+        }
+    }
+}
+
+#if BMB_REDUNDANT_ADC_CHECK || BMB_OPEN_WIRE_CHECK
+
+/*!
+  @brief   Read a result register group from every bmb and decode it. A bmb whose data is lost keeps no results
+           for the group.
+  @param   pack - Pack telemetry to update.
+  @param   command - Read command of the register group, or of the bulk read.
+  @param   registerSize - Bytes each bmb returns.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+static void readResultGroup(PackTelemetry_S *pack, uint16_t command, uint32_t registerSize, uint32_t numBmbs)
+{
+    uint8_t registerData[registerSize * numBmbs];
+    bool bmbValid[numBmbs];
+    trackConversionState(readAll(command, numBmbs, registerData, bmbValid));
+
+    uint32_t numMaps;
+    const RegisterMap_S *map = findRegisterMap(command, &numMaps);
+    for(int32_t k = 0; k < numBmbs; k++)
+    {
+        if(!bmbValid[k])
+        {
+            invalidateRegisterMap(pack, k, map, numMaps);
+        }
+        else if(!decodeRegisterMap(pack, NULL, k, map, numMaps, registerData + (k * registerSize)))
+        {
+            handleBmbReset();
+        }
+    }
+}
+
+#endif
+
+#if BMB_REDUNDANT_ADC_CHECK
+
+/*!
+  @brief   Read the redundant S-ADC cell voltages of every bmb with the C-ADC results of the same conversion,
+           checking them against each other as they are decoded. Reads one register group of each per call when
+           rotating, otherwise all of them.
+  @param   pack - Pack telemetry to update.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+static void readRedundantVoltages(PackTelemetry_S *pack, uint32_t numBmbs)
+{
+#if BMB_OPEN_WIRE_CHECK
+    redundantReadsSinceOpenWire++;
+#endif
+
+    // The C-ADC group goes first, so each S-ADC result finds its C-ADC result decoded
+#if BMB_REDUNDANT_ADC_ROTATE
+    readResultGroup(pack, readCAdcReg[redundantGroup], REGISTER_SIZE_BYTES, numBmbs);
+    readResultGroup(pack, readSAdcReg[redundantGroup], REGISTER_SIZE_BYTES, numBmbs);
+    redundantGroup = (redundantGroup + 1) % NUM_VOLT_REG;
+#else
+    readResultGroup(pack, READ_CADC_REG_ALL, ALL_REGISTER_SIZE_BYTES, numBmbs);
+    readResultGroup(pack, READ_SADC_REG_ALL, ALL_REGISTER_SIZE_BYTES, numBmbs);
+#endif
+}
+
+#endif
+
+/*!
+  @brief   Start the C-ADC, with the S-ADC alongside unless an open wire check holds it.
+  @param   command - Start command, with the redundant measurement bit set.
+  @param   numBmbs - Number of bmbs in the chain.
+  @return  Status of the command.
+*/
+static TRANSACTION_STATUS_E startCellConversions(uint16_t command, uint32_t numBmbs)
+{
+#if BMB_OPEN_WIRE_CHECK
+    if(openWireStep != OPEN_WIRE_IDLE)
+    {
+        command &= ~START_ADC_REDUNDANT;
+    }
+#endif
+    redundantStarted = ((command & START_ADC_REDUNDANT) != 0);
+    return commandAll(command, numBmbs);
+}
+
+#if BMB_OPEN_WIRE_CHECK
+
+/*!
+  @brief   Estimate the bus time of the next open wire step.
+  @param   numBmbs - Number of bmbs in the chain.
+  @return  Bus time in us.
+*/
+static uint32_t getOpenWireStepCost(uint32_t numBmbs)
+{
+    if(openWireStep != OPEN_WIRE_READ)
+    {
+        // Taking the S-ADC restarts the C-ADC without it, and each polarity is a single start command
+        return COMMAND_BUS_TIME_US;
+    }
+
+    // Each read takes the C-ADC group alongside the S-ADC group. The first read of a polarity polls for the
+    // conversion first, and the last one restarts the C-ADC with the S-ADC alongside again
+    bool lastRead = (openWirePolarity == SADC_OPEN_WIRE_ODD) && (openWireGroup == (NUM_VOLT_REG - 1));
+    return (2 * READ_BUS_TIME_US(numBmbs)) + ((openWirePolled) ? (0) : (POLL_BUS_TIME_US)) + ((lastRead) ? (COMMAND_BUS_TIME_US) : (0));
+}
+
+/*!
+  @brief   Read one S-ADC register group of the open wire conversion and compare it against the unaveraged C-ADC
+           results of the same group, which are read and decoded just before it. The averaged results would lag
+           a real cell step and report it as an open wire. The first polarity starts the group's results and the second adds to them
+           and publishes them. A bmb whose data is lost keeps no open wire results for the cells read.
+  @param   pack - Pack telemetry to update.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+static void readOpenWireGroup(PackTelemetry_S *pack, uint32_t numBmbs)
+{
+    // The redundant check pauses while the S-ADC is held, so the C-ADC results it reads would be stale
+    readResultGroup(pack, readCAdcReg[openWireGroup], REGISTER_SIZE_BYTES, numBmbs);
+
+    uint8_t registerData[REGISTER_SIZE_BYTES * numBmbs];
+    bool bmbValid[numBmbs];
+    trackConversionState(readAll(readSAdcReg[openWireGroup], numBmbs, registerData, bmbValid));
+
+    const RegisterMap_S *map = &openWireRegisterMap[openWireGroup];
+    const uint32_t firstCell = map->firstIndex;
+    const uint32_t groupMask = ((1UL << map->numFields) - 1) << firstCell;
+    const bool firstPolarity = (openWirePolarity == SADC_OPEN_WIRE_EVEN);
+    for(int32_t k = 0; k < numBmbs; k++)
+    {
+        uint32_t checked = 0;
+        uint32_t found = 0;
+        if(!bmbValid[k])
+        {
+            invalidateRegisterMap(pack, k, map, 1);
+        }
+        else if(!decodeRegisterMap(pack, NULL, k, map, 1, registerData + (k * REGISTER_SIZE_BYTES)))
+        {
+            handleBmbReset();
+        }
+        else
+        {
+            checked = pack->cAdcVoltageValid[k] & pack->openWireVoltageValid[k] & groupMask;
+            found = compareRedundantResults(pack->cAdcVoltage[k] + firstCell, pack->openWireVoltage[k] + firstCell,
+                                            map->numFields, OPEN_WIRE_THRESHOLD) << firstCell;
+        }
+
+        if(firstPolarity)
+        {
+            openWireChecked[k] = (openWireChecked[k] & ~groupMask) | checked;
+            openWireFound[k] = (openWireFound[k] & ~groupMask) | (found & checked);
+        }
+        else
+        {
+            // A cell is only checked once both of its taps have been pulled down
+            openWireChecked[k] &= checked | ~groupMask;
+            openWireFound[k] |= found & checked;
+            pack->cellOpenWire[k] = (pack->cellOpenWire[k] & ~groupMask) | (openWireFound[k] & openWireChecked[k] & groupMask);
+            pack->cellOpenWireValid[k] = (pack->cellOpenWireValid[k] & ~groupMask) | (openWireChecked[k] & groupMask);
+        }
+    }
+}
+
+/*!
+  @brief   Run the next step of the open wire check if the bus budget covers it. A check starts once the redundant
+           check has covered every cell since the last one.
+  @param   pack - Pack telemetry to update.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+static void runOpenWireStep(PackTelemetry_S *pack, uint32_t numBmbs)
+{
+    // The budget fills with the configured share of the time since it was last topped up
+    const uint32_t maxStepUs = OPEN_WIRE_MAX_STEP_US(numBmbs);
+    uint32_t now = HAL_GetTick();
+    // Time beyond what fills the budget adds nothing, and clamping it keeps the product from overflowing after a long gap
+    const uint32_t maxElapsedMs = (maxStepUs / OPEN_WIRE_BUDGET_US_PER_MS) + 1;
+    uint32_t elapsedMs = now - openWireBudgetTick;
+    elapsedMs = (elapsedMs > maxElapsedMs) ? (maxElapsedMs) : (elapsedMs);
+    openWireBudgetUs += elapsedMs * OPEN_WIRE_BUDGET_US_PER_MS;
+    openWireBudgetUs = (openWireBudgetUs > maxStepUs) ? (maxStepUs) : (openWireBudgetUs);
+    openWireBudgetTick = now;
+
+    uint32_t cost = getOpenWireStepCost(numBmbs);
+    if((cost > openWireBudgetUs) || ((openWireStep == OPEN_WIRE_IDLE) && (redundantReadsSinceOpenWire < OPEN_WIRE_SPACING_READS)))
+    {
+        return;
+    }
+    openWireBudgetUs -= cost;
+
+    switch(openWireStep)
+    {
+        case OPEN_WIRE_IDLE:
+            // Conversions restart without the S-ADC, which is then free from the next scan
+            openWireStep = OPEN_WIRE_CONVERT;
+            openWirePolarity = SADC_OPEN_WIRE_EVEN;
+            conversionsRunning = false;
+            break;
+
+        case OPEN_WIRE_CONVERT:
+        {
+            TRANSACTION_STATUS_E status = commandAll(CMD_START_SADC | openWirePolarity, numBmbs);
+            trackConversionState(status);
+            if((status == TRANSACTION_SUCCESS) && (openWireStep == OPEN_WIRE_CONVERT))
+            {
+                openWireStep = OPEN_WIRE_READ;
+                openWireGroup = 0;
+                openWirePolled = false;
+            }
+            break;
+        }
+
+        case OPEN_WIRE_READ:
+            if(!openWirePolled)
+            {
+                // The pulled down taps settle slower than a normal conversion, so a step may find it still
+                // running. Only the poll is spent then. A failed poll goes ahead with the read, which reports it
+                bool complete = true;
+                if((pollAll(CMD_POLL_SADC, numBmbs, &complete) == TRANSACTION_SUCCESS) && !complete)
                 {
-                    bmb[k].cellVoltage[(i * CELLS_PER_REG) + j] = (rawAdc * ADC_RESOLUTION) + ADC_OFFSET;
-                    bmb[k].cellVoltageStatus[(i * CELLS_PER_REG) + j] = GOOD;
+                    openWireBudgetUs += cost - POLL_BUS_TIME_US;
+                    break;
                 }
+                openWirePolled = true;
+            }
+
+            readOpenWireGroup(pack, numBmbs);
+
+            // A bmb that may have been reset restarts the check
+            if(openWireStep != OPEN_WIRE_READ)
+            {
+                break;
+            }
+            openWireGroup++;
+            if((openWireGroup == NUM_VOLT_REG) && (openWirePolarity == SADC_OPEN_WIRE_EVEN))
+            {
+                openWireStep = OPEN_WIRE_CONVERT;
+                openWirePolarity = SADC_OPEN_WIRE_ODD;
+            }
+            else if(openWireGroup == NUM_VOLT_REG)
+            {
+                // Hand the S-ADC back to the redundant check
+                openWireStep = OPEN_WIRE_IDLE;
+                conversionsRunning = false;
+                redundantReadsSinceOpenWire = 0;
             }
+            break;
+    }
+}
+
+#endif
+
+/*!
+  @brief   Restore everything a reset loses if a transaction shows a bmb may have been reset.
+  @param   status - Status of a transaction with the chain.
+*/
+static void trackConversionState(TRANSACTION_STATUS_E status)
+{
+    // A power on reset stops conversions and restores the default configuration, and a command counter
+    // mismatch means a start or write may have been missed
+    if((status == TRANSACTION_POR_ERROR) || (status == TRANSACTION_COMMAND_COUNTER_ERROR))
+    {
+        handleBmbReset();
+    }
+    commandMissed |= (status == TRANSACTION_COMMAND_COUNTER_ERROR);
+}
+
+/*!
+  @brief   Called when a decode finds a cleared result, meaning the bmb has not converted since it was reset, to
+           restore everything the reset lost. Marks conversions for a restart, and the cell limits and thermistor
+           mux channel for a rewrite. A running open wire check starts over.
+*/
+static void handleBmbReset(void)
+{
+    conversionsRunning = false;
+    cellLimitsWritten = false;
+#if BMB_THERMISTOR_SCAN
+    thermistorSelected = false;
+#endif
+#if BMB_OPEN_WIRE_CHECK
+    openWireStep = OPEN_WIRE_IDLE;
+#endif
+}
+
+#if BMB_THERMISTOR_SCAN
+
+/*!
+  @brief   Start the aux conversion of the selected mux channel once the mux has settled.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+static void startThermistorConversion(uint32_t numBmbs)
+{
+    if(thermistorSelected && !thermistorConversionStarted &&
+       ((HAL_GetTick() - thermistorSelectTick) > BMB_THERMISTOR_SETTLING_MS))
+    {
+        TRANSACTION_STATUS_E status = commandAll(CMD_START_AUX_ADC, numBmbs);
+        trackConversionState(status);
+        thermistorConversionStarted = (status == TRANSACTION_SUCCESS);
+    }
+}
+
+/*!
+  @brief   Read the mux outputs and store them as the thermistors of the selected channel. A bmb whose data is
+           lost keeps no results for these thermistors.
+  @param   pack - Pack telemetry to update.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+static void readThermistorChannel(PackTelemetry_S *pack, uint32_t numBmbs)
+{
+    uint8_t registerData[REGISTER_SIZE_BYTES * numBmbs];
+    bool bmbValid[numBmbs];
+    trackConversionState(readAll(READ_AUX_REG_A, numBmbs, registerData, bmbValid));
+
+    // The GPIOs decode as usual, then the mux outputs are copied to the thermistors of the channel
+    uint32_t numMaps;
+    const RegisterMap_S *map = findRegisterMap(READ_AUX_REG_A, &numMaps);
+    const uint32_t firstThermistor = thermistorChannel * NUM_THERMISTOR_MUX_INPUTS;
+    const uint32_t inputMask = (1UL << NUM_THERMISTOR_MUX_INPUTS) - 1;
+    for(int32_t k = 0; k < numBmbs; k++)
+    {
+        if(!bmbValid[k])
+        {
+            invalidateRegisterMap(pack, k, map, numMaps);
+        }
+        else if(!decodeRegisterMap(pack, NULL, k, map, numMaps, registerData + (k * REGISTER_SIZE_BYTES)))
+        {
+            handleBmbReset();
+        }
+
+        memcpy(&pack->thermistorVoltage[k][firstThermistor], pack->gpioVoltage[k], NUM_THERMISTOR_MUX_INPUTS * sizeof(int16_t));
+        pack->thermistorVoltageValid[k] = (pack->thermistorVoltageValid[k] & ~(inputMask << firstThermistor)) |
+                                          ((pack->gpioVoltageValid[k] & inputMask) << firstThermistor);
+        for(uint32_t input = 0; input < NUM_THERMISTOR_MUX_INPUTS; input++)
+        {
+            convertThermistor(pack, k, firstThermistor + input);
         }
     }
-    uint8_t registerData[REGISTER_SIZE_BYTES];
-    memset(registerData, 0, REGISTER_SIZE_BYTES);
-    readAll(readVoltReg[5], numBmbs, registerData);
+}
+
+/*!
+  @brief   Convert a thermistor voltage to its temperature and flag an open or shorted thermistor.
+  @param   pack - Pack telemetry to update, with the thermistor voltage already stored.
+  @param   bmb - Index of the bmb in the chain.
+  @param   thermistor - Index of the thermistor on the bmb.
+*/
+static void convertThermistor(PackTelemetry_S *pack, uint32_t bmb, uint32_t thermistor)
+{
+    const uint32_t bit = 1UL << thermistor;
+    THERMISTOR_STATUS_E status = THERMISTOR_OK;
+    bool read = (pack->thermistorVoltageValid[bmb] & bit) != 0;
+    if(read)
+    {
+        status = thermistorCodeToTemperature(pack->thermistorVoltage[bmb][thermistor], &pack->thermistorTemperature[bmb][thermistor]);
+    }
+
+    // A thermistor that was not read keeps no temperature and no fault
+    pack->thermistorTemperatureValid[bmb] = (pack->thermistorTemperatureValid[bmb] & ~bit) | ((read && (status == THERMISTOR_OK)) ? (bit) : (0));
+    pack->thermistorOpen[bmb] = (pack->thermistorOpen[bmb] & ~bit) | ((read && (status == THERMISTOR_OPEN)) ? (bit) : (0));
+    pack->thermistorShort[bmb] = (pack->thermistorShort[bmb] & ~bit) | ((read && (status == THERMISTOR_SHORT)) ? (bit) : (0));
+}
+
+/*!
+  @brief   Collect the thermistors converted during the scan and select the next mux channel.
+  @param   pack - Pack telemetry to update.
+  @param   numBmbs - Number of bmbs in the chain.
+  @return  False if the aux conversion is still running, so nothing was read or selected.
+*/
+static bool updateThermistors(PackTelemetry_S *pack, uint32_t numBmbs)
+{
+    if(thermistorConversionStarted)
+    {
+        // A short chain can finish its readout before the aux conversion, which is then polled again on the
+        // next call. A failed poll goes ahead with the read, which finds and reports the fault
+        bool complete = true;
+        if((pollAll(CMD_POLL_AUX_ADC, numBmbs, &complete) == TRANSACTION_SUCCESS) && !complete)
+        {
+            return false;
+        }
+
+        // Results converted after a bmb may have fallen back to its default channel are dropped
+        thermistorConversionStarted = false;
+        if(thermistorSelected)
+        {
+            readThermistorChannel(pack, numBmbs);
+            thermistorChannel = (thermistorChannel + 1) % NUM_THERMISTOR_MUX_CHANNELS;
+            thermistorSelected = false;
+        }
+    }
+
+    if(!thermistorSelected)
+    {
+        // GPO 9-10 are the low bits of byte 4
+        uint8_t config[REGISTER_SIZE_BYTES] = { CONFIG_A_RESET_0, 0x00, 0x00, CONFIG_A_GPO_1_8, (uint8_t)thermistorChannel, 0x00 };
+        thermistorSelected = (writeAll(WRITE_CONFIG_REG_A, numBmbs, config) == TRANSACTION_SUCCESS);
+        thermistorSelectTick = HAL_GetTick();
+    }
+    return true;
+}
+
+#endif
+
+/*!
+  @brief   Estimate the bus time of a diagnostic.
+  @param   diagnostic - The diagnostic to run.
+  @param   numBmbs - Number of bmbs in the chain.
+  @return  Bus time in us.
+*/
+static uint32_t getDiagnosticCost(DIAGNOSTIC_E diagnostic, uint32_t numBmbs)
+{
+#if BMB_THERMISTOR_SCAN
+    (void)diagnostic;
+    return READ_BUS_TIME_US(numBmbs);
+#else
+    // Without the thermistor scan the aux results are only converted by the diagnostics themselves
+    return READ_BUS_TIME_US(numBmbs) + ((diagnostics[diagnostic].auxConverted) ? (COMMAND_BUS_TIME_US) : (0));
+#endif
+}
+
+/*!
+  @brief   Read the register group of a diagnostic from every bmb. A bmb whose data is lost keeps no results
+           for the group.
+  @param   pack - Pack telemetry to update.
+  @param   diagnostic - The diagnostic to run.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+static void runDiagnostic(PackTelemetry_S *pack, DIAGNOSTIC_E diagnostic, uint32_t numBmbs)
+{
+    const uint16_t command = diagnostics[diagnostic].command;
+    uint8_t registerData[REGISTER_SIZE_BYTES * numBmbs];
+    bool bmbValid[numBmbs];
+    trackConversionState(readAll(command, numBmbs, registerData, bmbValid));
+
+    uint32_t numMaps = 0;
+    const RegisterMap_S *map = (diagnostic == DIAGNOSTIC_FAULTS) ? (NULL) : (findRegisterMap(command, &numMaps));
     for(int32_t k = 0; k < numBmbs; k++)
     {
-        uint16_t rawAdcLSB = registerData[(k * REGISTER_SIZE_BYTES)];
-        uint16_t rawAdcMSB = registerData[(k * REGISTER_SIZE_BYTES) + 1];
-        uint16_t rawAdc = (rawAdcMSB << BITS_IN_BYTE) | (rawAdcLSB);
-        if(isAdcRailed(rawAdc))
+        const uint8_t *data = registerData + (k * REGISTER_SIZE_BYTES);
+        if(map == NULL)
+        {
+            pack->bmbFaultFlags[k] = (bmbValid[k]) ? ((uint32_t)data[STATUS_C_FAULT_BYTE] | ((uint32_t)data[STATUS_C_FAULT_BYTE + 1] << 8)) : (0);
+            pack->bmbFaultFlagsValid[k] = (bmbValid[k]) ? (ALL_FAULTS_MASK) : (0);
+        }
+        else if(!bmbValid[k])
         {
-            bmb[k].cellVoltageStatus[(5 * CELLS_PER_REG)] = BAD;
+            invalidateRegisterMap(pack, k, map, numMaps);
         }
         else
         {
-            bmb[k].cellVoltage[(5 * CELLS_PER_REG)] = (rawAdc * ADC_RESOLUTION) + ADC_OFFSET;
-            bmb[k].cellVoltageStatus[(5 * CELLS_PER_REG)] = GOOD;
+            // Aux results stay cleared until the first aux conversion after a reset, which the cell results
+            // already show, so a cleared result only leaves the measurement bad
+            decodeRegisterMap(pack, NULL, k, map, numMaps, data);
         }
     }
 
-    commandAll(CMD_START_ADC, numBmbs);
+#if !BMB_THERMISTOR_SCAN
+    // Convert the aux results for the next read of any aux diagnostic
+    if(diagnostics[diagnostic].auxConverted)
+    {
+        trackConversionState(commandAll(CMD_START_AUX_ADC, numBmbs));
+    }
+#endif
 }
 
-void testRead(Bmb_S* bmb, uint32_t numBmbs)
+/*!
+  @brief   Read the module voltages of every bmb and check them against the cell voltages. A bmb whose data is
+           lost keeps no module voltages.
+  @param   pack - Pack telemetry to update.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+static void readModuleVoltages(PackTelemetry_S *pack, uint32_t numBmbs)
+{
+    uint8_t registerData[REGISTER_SIZE_BYTES * numBmbs];
+    bool bmbValid[numBmbs];
+    trackConversionState(readAll(READ_AUX_REG_D, numBmbs, registerData, bmbValid));
+
+    uint32_t numMaps;
+    const RegisterMap_S *map = findRegisterMap(READ_AUX_REG_D, &numMaps);
+    for(int32_t k = 0; k < numBmbs; k++)
+    {
+        if(!bmbValid[k])
+        {
+            invalidateRegisterMap(pack, k, map, numMaps);
+        }
+        else
+        {
+            // GPIO 10 and VMV stay cleared after a reset until the scan converts every aux channel, and the cell
+            // results already show the reset, so a cleared result only leaves the measurement bad
+            decodeRegisterMap(pack, NULL, k, map, numMaps, registerData + (k * REGISTER_SIZE_BYTES));
+        }
+    }
+    checkSumOfCells(pack, numBmbs);
+}
+
+/*!
+  @brief   Check each bmb's sum of cells result against the sum of its cell voltages, and add the results up to
+           the coarse pack voltage.
+  @param   pack - Pack telemetry to update, with the module voltages just read.
+  @param   numBmbs - Number of bmbs in the chain.
+*/
+static void checkSumOfCells(PackTelemetry_S *pack, uint32_t numBmbs)
+{
+    int32_t packVoltage = 0;
+    uint32_t numPackVoltages = 0;
+    for(int32_t k = 0; k < numBmbs; k++)
+    {
+        const bool sumValid = (pack->moduleVoltageValid[k] & (1UL << MODULE_VOLTAGE_VPV)) != 0;
+        const bool checked = sumValid && (pack->cellVoltageValid[k] == ALL_CELLS_MASK);
+        int32_t difference = 0;
+        if(checked)
+        {
+            // Both sides in cell codes with the offsets added back, since V+ scales its offset along with the sum
+            int32_t cellSum = NUM_CELLS_PER_BMB * ADC_OFFSET_CODES;
+            for(uint32_t cell = 0; cell < NUM_CELLS_PER_BMB; cell++)
+            {
+                cellSum += pack->cellVoltage[k][cell];
+            }
+            difference = cellSum - (MODULE_VOLTAGE_SCALE_CODES * (pack->moduleVoltage[k][MODULE_VOLTAGE_VPV] + ADC_OFFSET_CODES));
+        }
+        pack->sumOfCellsMismatch[k] = checked && ((difference > SUM_OF_CELLS_TOLERANCE) || (difference < -SUM_OF_CELLS_TOLERANCE));
+        pack->sumOfCellsChecked[k] = checked;
+
+        packVoltage += (sumValid) ? (pack->moduleVoltage[k][MODULE_VOLTAGE_VPV]) : (0);
+        numPackVoltages += (sumValid) ? (1) : (0);
+    }
+    pack->modulePackVoltage = packVoltage;
+    pack->numModulePackVoltages = numPackVoltages;
+}
+
+/*!
+  @brief   Convert a cell voltage to the nearest comparator threshold code.
+  @param   volts - The cell voltage.
+  @return  The threshold, clamped to the 12-bit range.
+*/
+static int32_t voltsToCellThreshold(float volts)
+{
+    float threshold = (volts - ADC_OFFSET) / (ADC_RESOLUTION * (1 << CELL_THRESHOLD_SHIFT));
+    int32_t rounded = (int32_t)(threshold + ((threshold >= 0.0f) ? (0.5f) : (-0.5f)));
+    return (rounded < CELL_THRESHOLD_MIN) ? (CELL_THRESHOLD_MIN) : ((rounded > CELL_THRESHOLD_MAX) ? (CELL_THRESHOLD_MAX) : (rounded));
+}
+
+/*!
+  @brief   Gather the even bits of a word into its low half.
+  @param   bits - Word to compact.
+  @return  Bit n is bit 2n of the word.
+*/
+static uint32_t compactEvenBits(uint32_t bits)
+{
+    bits &= 0x55555555UL;
+    bits = (bits | (bits >> 1)) & 0x33333333UL;
+    bits = (bits | (bits >> 2)) & 0x0F0F0F0FUL;
+    bits = (bits | (bits >> 4)) & 0x00FF00FFUL;
+    bits = (bits | (bits >> 8)) & 0x0000FFFFUL;
+    return bits;
+}
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+bool isBmbTelemetryReady(uint32_t numBmbs)
+{
+#if BMB_CONTINUOUS_CONVERSION
+    if(conversionsRunning && conversionsComplete)
+    {
+        return true;
+    }
+#endif
+
+    // A failed poll lets the scan go ahead, which finds and reports the fault
+    bool complete = true;
+    if(pollAll(CMD_POLL_ADC, numBmbs, &complete) != TRANSACTION_SUCCESS)
+    {
+        return true;
+    }
+    conversionsComplete = complete;
+    return complete;
+}
+
+bool decodeRegisterGroup(PackTelemetry_S *pack, PackStatsAccumulator_S *scanStats, uint32_t bmb, uint16_t command, const uint8_t *registerData)
+{
+    uint32_t numMaps;
+    const RegisterMap_S *map = findRegisterMap(command, &numMaps);
+    return decodeRegisterMap(pack, scanStats, bmb, map, numMaps, registerData);
+}
+
+float adcCodeToVolts(int16_t code)
+{
+    return (code * ADC_RESOLUTION) + ADC_OFFSET;
+}
+
+float adcCodeSpanToVolts(int32_t span)
+{
+    return span * ADC_RESOLUTION;
+}
+
+float adcCodeSumToVolts(int32_t sum, uint32_t numCodes)
+{
+    return (sum * ADC_RESOLUTION) + (numCodes * ADC_OFFSET);
+}
+
+float adcCodeToModuleVolts(int16_t code)
+{
+    return ((code * ADC_RESOLUTION) + ADC_OFFSET) * MODULE_VOLTAGE_SCALE;
+}
+
+float adcCodeSumToModuleVolts(int32_t sum, uint32_t numCodes)
+{
+    return ((sum * ADC_RESOLUTION) + (numCodes * ADC_OFFSET)) * MODULE_VOLTAGE_SCALE;
+}
+
+float adcCodeToDieTemperature(int16_t code)
+{
+    return (code * ITMP_RESOLUTION) + ITMP_OFFSET;
+}
+
+void updateBmbTelemetry(PackTelemetry_S *pack, PackStats_S *stats, uint32_t numBmbs)
+{
+    resetPackStats(&scanStats);
+    redundantReady = redundantStarted;
+
+#if BMB_SNAPSHOT_SCAN
+    // A read after the last scan's release may have found a missed command, so release again in case a bmb
+    // is still frozen on an old conversion
+    if(commandMissed)
+    {
+        // A bmb that misses this release shows up in the command counter of the read below
+        commandAll(CMD_RELEASE_SNAPSHOT, numBmbs);
+        commandMissed = false;
+    }
+
+    // Freeze the results on every bmb at once, so every cell in the scan comes from the same conversion
+    // and the next conversion cannot overwrite them during the readout
+    trackConversionState(commandAll(CMD_SNAPSHOT, numBmbs));
+#endif
+#if BMB_PIPELINED_SCAN && !BMB_CONTINUOUS_CONVERSION
+    // A missed start is caught by the command counter check of the readout below, which restarts conversions
+    startCellConversions(CMD_START_ADC, numBmbs);
+#endif
+#if BMB_THERMISTOR_SCAN
+    // The mux has been settling since the last scan, so convert it while the cells are read out
+    startThermistorConversion(numBmbs);
+#endif
+
+    // Read every cell voltage register from every bmb in a single transaction
+    uint8_t registerData[ALL_REGISTER_SIZE_BYTES * numBmbs];
+    bool bmbValid[numBmbs];
+    TRANSACTION_STATUS_E readStatus = readAll(READ_VOLT_REG_ALL, numBmbs, registerData, bmbValid);
+    trackConversionState(readStatus);
+
+#if BMB_SNAPSHOT_SCAN
+    // A command counter mismatch means a bmb missed a command, possibly the last release or this snapshot,
+    // so its results may come from another conversion. Frame a new snapshot and read everything again
+    if(readStatus == TRANSACTION_COMMAND_COUNTER_ERROR)
+    {
+        // The repeated read checks the command counter again, so a bmb that misses either command is marked
+        // for another release by trackConversionState
+        commandAll(CMD_RELEASE_SNAPSHOT, numBmbs);
+        commandAll(CMD_SNAPSHOT, numBmbs);
+        commandMissed = false;
+        trackConversionState(readAll(READ_VOLT_REG_ALL, numBmbs, registerData, bmbValid));
+    }
+#endif
+
+    // Decode every bmb that returned a valid packet, even if others in the chain did not
+    uint32_t numMaps;
+    const RegisterMap_S *map = findRegisterMap(READ_VOLT_REG_ALL, &numMaps);
+    bool allValid = true;
+    for(int32_t k = 0; k < numBmbs; k++)
+    {
+        if(!bmbValid[k])
+        {
+            allValid = false;
+            continue;
+        }
+
+        if(!decodeRegisterMap(pack, &scanStats, k, map, numMaps, registerData + (k * ALL_REGISTER_SIZE_BYTES)))
+        {
+            handleBmbReset();
+        }
+    }
+
+    if(!allValid)
+    {
+        // A single corrupted register group fails the entire bulk packet, so retry the missing bmbs one register at a time
+        readCellVoltagesPerRegister(pack, &scanStats, numBmbs, bmbValid);
+    }
+
+    // Every cell has now been decoded or marked bad, so the statistics cover the whole scan
+    publishPackStats(&scanStats, stats);
+
+#if BMB_REDUNDANT_ADC_CHECK
+    // Read before the results are released, so both ADCs report the same conversion. Skipped while the
+    // conversion read ran without the S-ADC
+    if(redundantReady)
+    {
+        readRedundantVoltages(pack, numBmbs);
+    }
+#endif
+
+#if BMB_SNAPSHOT_SCAN
+    trackConversionState(commandAll(CMD_RELEASE_SNAPSHOT, numBmbs));
+#endif
+
+#if BMB_OPEN_WIRE_CHECK
+    // Run after the release so the open wire results can land, and before the restart so taking or handing
+    // back the S-ADC restarts conversions in the same scan
+    runOpenWireStep(pack, numBmbs);
+#endif
+
+#if BMB_CONTINUOUS_CONVERSION
+    // Conversions only need starting once, and again whenever a bmb may have stopped converting
+    if(!conversionsRunning)
+    {
+        conversionsRunning = (startCellConversions(CMD_START_ADC_CONTINUOUS, numBmbs) == TRANSACTION_SUCCESS);
+        conversionsComplete = false;
+    }
+#elif !BMB_PIPELINED_SCAN
+    // The next scan's readout checks the command counter, and a missed start leaves the results cleared
+    startCellConversions(CMD_START_ADC, numBmbs);
+#endif
+
+#if BMB_THERMISTOR_SCAN
+    // Read the channel and select the next between scans, which leaves the mux until the next scan to settle
+    thermistorReadoutDue = true;
+#endif
+}
+
+const PackStatsAccumulator_S* getBmbScanStats(void)
+{
+    return &scanStats;
+}
+
+bool isBmbThermistorReadoutDue(void)
+{
+#if BMB_THERMISTOR_SCAN
+    return thermistorReadoutDue;
+#else
+    return false;
+#endif
+}
+
+void updateBmbThermistors(PackTelemetry_S *pack, uint32_t numBmbs)
+{
+#if BMB_THERMISTOR_SCAN
+    // The readout stays due while the aux conversion runs, so the next call polls it again
+    thermistorReadoutDue = !updateThermistors(pack, numBmbs);
+#endif
+}
+
+bool isBmbModuleVoltageDue(void)
+{
+    return moduleVoltageConversionStarted || ((HAL_GetTick() - moduleVoltageTick) >= BMB_MODULE_VOLTAGE_PERIOD_MS);
+}
+
+void updateBmbModuleVoltages(PackTelemetry_S *pack, uint32_t numBmbs)
+{
+    if(!moduleVoltageConversionStarted)
+    {
+        moduleVoltageTick = HAL_GetTick();
+#if BMB_THERMISTOR_SCAN
+        // A new start would cut short the thermistor conversion, which converts V+ along with the mux outputs,
+        // so one in flight is read instead
+        if(thermistorConversionStarted)
+        {
+            moduleVoltageConversionStarted = true;
+            return;
+        }
+        TRANSACTION_STATUS_E status = commandAll(CMD_START_VPV_ADC, numBmbs);
+#else
+        // The aux diagnostics read the results of the last conversion of every channel, which a V+ start could
+        // cut short. Restarting a conversion of every channel loses nothing
+        TRANSACTION_STATUS_E status = commandAll(CMD_START_AUX_ADC, numBmbs);
+#endif
+        trackConversionState(status);
+        moduleVoltageConversionStarted = (status == TRANSACTION_SUCCESS);
+        return;
+    }
+
+    // The scan may have started the thermistor conversion since, which converts V+ as well. A failed poll goes
+    // ahead with the read, which finds and reports the fault
+    bool complete = true;
+    if((pollAll(CMD_POLL_AUX_ADC, numBmbs, &complete) == TRANSACTION_SUCCESS) && !complete)
+    {
+        return;
+    }
+    moduleVoltageConversionStarted = false;
+    readModuleVoltages(pack, numBmbs);
+}
+
+void setCellVoltageLimits(float underVoltage, float overVoltage)
+{
+    uint32_t underThreshold = (uint32_t)voltsToCellThreshold(underVoltage) & CELL_THRESHOLD_MASK;
+    uint32_t overThreshold = (uint32_t)voltsToCellThreshold(overVoltage) & CELL_THRESHOLD_MASK;
+
+    // VUV[7:0], VOV[3:0] and VUV[11:8], VOV[11:4], then no discharge timer and no cells discharging
+    memset(cellLimitConfig, 0, sizeof(cellLimitConfig));
+    cellLimitConfig[0] = (uint8_t)underThreshold;
+    cellLimitConfig[1] = (uint8_t)((overThreshold << 4) | (underThreshold >> BITS_IN_BYTE));
+    cellLimitConfig[2] = (uint8_t)(overThreshold >> 4);
+    cellLimitsSet = true;
+    cellLimitsWritten = false;
+}
+
+void updateCellVoltageFlags(PackTelemetry_S *pack, uint32_t numBmbs)
+{
+    if(cellLimitsSet && !cellLimitsWritten)
+    {
+        cellLimitsWritten = (writeAll(WRITE_CONFIG_REG_B, numBmbs, cellLimitConfig) == TRANSACTION_SUCCESS);
+    }
+
+    uint8_t registerData[REGISTER_SIZE_BYTES * numBmbs];
+    bool bmbValid[numBmbs];
+    trackConversionState(readAll(READ_STATUS_REG_D, numBmbs, registerData, bmbValid));
+
+    // Each cell has an undervoltage flag followed by an overvoltage flag, four cells to a byte
+    bool flagged = false;
+    for(int32_t k = 0; k < numBmbs; k++)
+    {
+        if(!bmbValid[k])
+        {
+            pack->cellVoltageFlagsValid[k] = 0;
+            continue;
+        }
+
+        const uint8_t *data = registerData + (k * REGISTER_SIZE_BYTES);
+        uint32_t flags = (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+        pack->cellUndervoltageFlags[k] = compactEvenBits(flags);
+        pack->cellOvervoltageFlags[k] = compactEvenBits(flags >> 1);
+        pack->cellVoltageFlagsValid[k] = ALL_CELLS_MASK;
+        flagged |= (flags != 0);
+    }
+
+    // The flags latch, so clear the ones just read and a cell that recovers stops being reported
+    if(flagged)
+    {
+        trackConversionState(commandAll(CMD_CLEAR_CELL_FLAGS, numBmbs));
+    }
+}
+
+void updateBmbDiagnostics(PackTelemetry_S *pack, DiagnosticStats_S *stats, uint32_t numBmbs)
+{
+    uint32_t now = HAL_GetTick();
+    if(!diagnosticsStarted)
+    {
+        for(uint32_t i = 0; i < NUM_DIAGNOSTICS; i++)
+        {
+            diagnosticTick[i] = now;
+        }
+        diagnosticCycleTick = now;
+        diagnosticsStarted = true;
+    }
+    if((now - diagnosticCycleTick) >= BMB_DIAGNOSTIC_CYCLE_MS)
+    {
+        diagnosticCycleTick = now;
+        diagnosticBusTimeUs = 0;
+    }
+
+    // Of the diagnostics past half their period, the one nearest its deadline goes first
+    int32_t nextSlack = INT32_MAX;
+    uint32_t next = NUM_DIAGNOSTICS;
+    for(uint32_t i = 0; i < NUM_DIAGNOSTICS; i++)
+    {
+        uint32_t elapsed = now - diagnosticTick[i];
+        int32_t slack = (int32_t)diagnostics[i].periodMs - (int32_t)elapsed;
+        if((elapsed >= DIAGNOSTIC_EARLIEST_MS(diagnostics[i].periodMs)) && (slack < nextSlack))
+        {
+            nextSlack = slack;
+            next = i;
+        }
+    }
+    if(next == NUM_DIAGNOSTICS)
+    {
+        return;
+    }
+
+    // A diagnostic that cannot wait for the next cycle's budget runs now
+    uint32_t cost = getDiagnosticCost((DIAGNOSTIC_E)next, numBmbs);
+    bool forced = (nextSlack < BMB_DIAGNOSTIC_CYCLE_MS);
+    if(!forced && ((diagnosticBusTimeUs + cost) > BMB_DIAGNOSTIC_BUDGET_US))
+    {
+        return;
+    }
+
+    runDiagnostic(pack, (DIAGNOSTIC_E)next, numBmbs);
+    diagnosticBusTimeUs += cost;
+
+    uint32_t interval = now - diagnosticTick[next];
+    diagnosticTick[next] = now;
+    stats->runs[next]++;
+    stats->forcedRuns[next] += ((diagnosticBusTimeUs > BMB_DIAGNOSTIC_BUDGET_US) ? (1) : (0));
+    stats->busTimeUs[next] += cost;
+    stats->maxIntervalMs[next] = (interval > stats->maxIntervalMs[next]) ? (interval) : (stats->maxIntervalMs[next]);
+}
+
+void testRead(Bmb_S *bmb, uint32_t numBmbs)
 {
     wakeChain(numBmbs);
 
-    uint8_t registerData[REGISTER_SIZE_BYTES];
-    memset(registerData, 0, REGISTER_SIZE_BYTES);
-    static uint8_t data[6] = {0x01, 0x00, 0x00, 0x03, 0x01, 0x00};
+    uint8_t registerData[REGISTER_SIZE_BYTES * numBmbs];
+    bool bmbValid[numBmbs];
+    memset(registerData, 0, sizeof(registerData));
+    static uint8_t data[REGISTER_SIZE_BYTES] = {CONFIG_A_RESET_0, 0x00, 0x00, 0x03, 0x01, 0x00};
     static uint8_t ioSet = 0x00;
     ioSet++;
     data[4] = ioSet;
 
-    writeAll(0x0001, numBmbs, data);
-    bmb[0].status = readAll(0x0002, numBmbs, registerData);
-    
-    for(int32_t i = 0; i < REGISTER_SIZE_BYTES; i++)
-    {
-        // bmb[0].testData[i] = 0x02;
-        bmb[0].testData[i] = registerData[i];
-    }
-}
\ No newline at end of file
+    writeAll(WRITE_CONFIG_REG_A, numBmbs, data);
+    bmb[0].status = readAll(READ_CONFIG_REG_A, numBmbs, registerData, bmbValid);
+    memcpy(bmb[0].testData, registerData, REGISTER_SIZE_BYTES);
+}
@@ -9,7 +9,29 @@
 /* ============================= DEFINES ============================== */
 /* ==================================================================== */
 
-#define BMB_UPDATE_PERIOD_MS        50
+// Scans start as soon as the bmbs finish converting, but no sooner than this after the last scan
+#ifndef BMB_MIN_UPDATE_PERIOD_MS
+#define BMB_MIN_UPDATE_PERIOD_MS    50
+#endif
+
+// Between scans, poll the flags of the cell voltage comparators every bmb runs on each conversion. A cell crossing
+// its limit is then seen within a poll period, for a fraction of the bus time of a scan
+#ifndef BMB_HARDWARE_CELL_LIMITS
+#define BMB_HARDWARE_CELL_LIMITS    1
+#endif
+
+#ifndef BMB_CELL_FLAG_POLL_PERIOD_MS
+#define BMB_CELL_FLAG_POLL_PERIOD_MS    5
+#endif
+
+// Read the status groups within the diagnostic bus budget set in bmb.c, in a slot after each scan and in the time
+// left between scans and flag polls
+#ifndef BMB_DIAGNOSTICS
+#define BMB_DIAGNOSTICS     1
+#endif
+
+#define CELL_UNDERVOLTAGE_LIMIT_V   2.5f
+#define CELL_OVERVOLTAGE_LIMIT_V    4.2f
 
 /* ==================================================================== */
 /* ========================= LOCAL VARIABLES ========================== */
@@ -21,14 +43,60 @@ Bms_S gBms;
 /* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
 /* ==================================================================== */
 
+void initPackTelemetry()
+{
+#if BMB_HARDWARE_CELL_LIMITS
+    setCellVoltageLimits(CELL_UNDERVOLTAGE_LIMIT_V, CELL_OVERVOLTAGE_LIMIT_V);
+#endif
+}
+
 void updatePackTelemetry()
 {
     static uint32_t lastBmbUpdate = 0;
-    if((HAL_GetTick() - lastBmbUpdate) > BMB_UPDATE_PERIOD_MS)
+#if BMB_DIAGNOSTICS
+    static bool diagnosticSlot = false;
+#endif
+#if BMB_HARDWARE_CELL_LIMITS
+    static uint32_t lastFlagUpdate = 0;
+#endif
+    if(((HAL_GetTick() - lastBmbUpdate) >= BMB_MIN_UPDATE_PERIOD_MS) && isBmbTelemetryReady(NUM_BMBS_IN_ACCUMULATOR))
     {
         lastBmbUpdate = HAL_GetTick();
-        updateBmbTelemetry(gBms.bmb, NUM_BMBS_IN_ACCUMULATOR);
+        updateBmbTelemetry(&gBms.telemetry, &gBms.stats, NUM_BMBS_IN_ACCUMULATOR);
+#if BMB_DIAGNOSTICS
+        diagnosticSlot = true;
+#endif
+    }
+#if BMB_DIAGNOSTICS
+    // The pass after each scan goes to the diagnostics, so the flag polls and thermistor readout cannot hold them
+    // off for longer than their periods
+    else if(diagnosticSlot)
+    {
+        diagnosticSlot = false;
+        updateBmbDiagnostics(&gBms.telemetry, &gBms.diagnosticStats, NUM_BMBS_IN_ACCUMULATOR);
+    }
+#endif
+#if BMB_HARDWARE_CELL_LIMITS
+    else if((HAL_GetTick() - lastFlagUpdate) >= BMB_CELL_FLAG_POLL_PERIOD_MS)
+    {
+        lastFlagUpdate = HAL_GetTick();
+        updateCellVoltageFlags(&gBms.telemetry, NUM_BMBS_IN_ACCUMULATOR);
+    }
+#endif
+    else if(isBmbModuleVoltageDue())
+    {
+        updateBmbModuleVoltages(&gBms.telemetry, NUM_BMBS_IN_ACCUMULATOR);
+    }
+    else if(isBmbThermistorReadoutDue())
+    {
+        updateBmbThermistors(&gBms.telemetry, NUM_BMBS_IN_ACCUMULATOR);
+    }
+#if BMB_DIAGNOSTICS
+    else
+    {
+        updateBmbDiagnostics(&gBms.telemetry, &gBms.diagnosticStats, NUM_BMBS_IN_ACCUMULATOR);
     }
+#endif
 }
 
 void updateTestData()
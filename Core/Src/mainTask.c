@@ -5,6 +5,7 @@
 #include "mainTask.h"
 #include "main.h"
 #include "bms.h"
+#include "pec.h"
 
 /* ==================================================================== */
 /* ============================= DEFINES ============================== */
@@ -12,6 +13,15 @@
 
 #define MAIN_UPDATE_PERIOD_MS 1000
 
+// Share of the core the pack statistics may take at the 50 Hz scan rate before each printout flags them
+#define PACK_STATS_SCAN_RATE_HZ         50
+#define PACK_STATS_CPU_BUDGET_PERCENT   0.5f
+
+// Rewrite and read back config A every second, for bring-up. This takes over the thermistor mux select
+#ifndef BMB_TEST_READ
+#define BMB_TEST_READ   0
+#endif
+
 /* ==================================================================== */
 /* ======================= EXTERNAL VARIABLES ========================= */
 /* ==================================================================== */
@@ -27,6 +37,7 @@ extern Bms_S 	gBms;
 /* ==================================================================== */
 
 static void printCellVoltages();
+static void printThermistorTemperatures();
 
 /* ==================================================================== */
 /* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
@@ -34,14 +45,25 @@ static void printCellVoltages();
 
 void initMain()
 {
+    // Every bmb transaction depends on the crc tables, so do not run with a bad image
+    if(!pecSelfTest())
+    {
+        printf("PEC self test failed\n");
+        Error_Handler();
+    }
+
 	HAL_GPIO_WritePin(MAS1_GPIO_Port, MAS1_Pin, SET);
     HAL_GPIO_WritePin(MAS2_GPIO_Port, MAS2_Pin, SET);
+
+    initPackTelemetry();
 }
 
 void runMain()
 {
     updatePackTelemetry();
+#if BMB_TEST_READ
     updateTestData();
+#endif
 
     static uint32_t lastUpdateMain = 0;
     if((HAL_GetTick() - lastUpdateMain) > MAIN_UPDATE_PERIOD_MS)
@@ -49,15 +71,18 @@ void runMain()
         lastUpdateMain = HAL_GetTick();
         printf("\e[1;1H\e[2J");
         printCellVoltages();
+        printf("\n");
+        printThermistorTemperatures();
+#if BMB_TEST_READ
         printf("\n");
         printf("Test Read Result: \n");
-        for(int32_t i = 0; i < 6; i++)
+        for(int32_t i = 0; i < REGISTER_SIZE_BYTES; i++)
         {
             printf("%X\n", gBms.bmb[0].testData[i]);
         }
 
         printf("STATUS: %lu\n", (uint32_t)gBms.bmb[0].status);
-        
+#endif
     }
 }
 
@@ -75,10 +100,10 @@ static void printCellVoltages()
         printf("|    %02ld   |", i);
         for(int32_t j = 0; j < NUM_BMBS_IN_ACCUMULATOR; j++)
         {
-            if(gBms.bmb[j].cellVoltageStatus[i] == GOOD)
+            if(gBms.telemetry.cellVoltageValid[j] & (1UL << i))
             {
-                printf("  %5.3f  ", (double)gBms.bmb[j].cellVoltage[i]);
-                // printf("  %04X", gBms.bmb[j].cellVoltage[i]);
+                printf("  %5.3f  ", (double)adcCodeToVolts(gBms.telemetry.cellVoltage[j][i]));
+                // printf("  %04X", gBms.telemetry.cellVoltage[j][i]);
             }
             else
             {
@@ -88,4 +113,70 @@ static void printCellVoltages()
         }
     }
 	printf("\n");
-}
\ No newline at end of file
+
+    PackStats_S *stats = &gBms.stats;
+    if(stats->numValidCells > 0)
+    {
+        printf("Min: %5.3f (BMB %u cell %u)  Max: %5.3f (BMB %u cell %u)  Mean: %5.3f  Spread: %5.3f  Sum: %6.2f\n",
+               (double)adcCodeToVolts(stats->minCellVoltage), stats->minCellBmb, stats->minCell,
+               (double)adcCodeToVolts(stats->maxCellVoltage), stats->maxCellBmb, stats->maxCell,
+               (double)adcCodeToVolts(stats->meanCellVoltage), (double)adcCodeSpanToVolts(stats->cellVoltageSpread),
+               (double)adcCodeSumToVolts(stats->sumCellVoltage, stats->numValidCells));
+    }
+    if(stats->cycles > 0)
+    {
+        float cpuPercent = (100.0f * stats->cycles * PACK_STATS_SCAN_RATE_HZ) / SystemCoreClock;
+        printf("Statistics took %lu cycles, %5.3f %% of the core%s\n", stats->cycles, (double)cpuPercent,
+               (cpuPercent > PACK_STATS_CPU_BUDGET_PERCENT) ? ("  OVER BUDGET") : (""));
+    }
+
+    PackTelemetry_S *telemetry = &gBms.telemetry;
+    if(telemetry->numModulePackVoltages > 0)
+    {
+        printf("Sum of cells: %6.2f (%lu BMBs)", (double)adcCodeSumToModuleVolts(telemetry->modulePackVoltage, telemetry->numModulePackVoltages),
+               telemetry->numModulePackVoltages);
+        for(int32_t i = 0; i < NUM_BMBS_IN_ACCUMULATOR; i++)
+        {
+            if(telemetry->sumOfCellsMismatch[i])
+            {
+                printf("  BMB %ld MISMATCH", i);
+            }
+        }
+        printf("\n");
+    }
+}
+
+static void printThermistorTemperatures()
+{
+    printf("Thermistor Temperature:\n");
+    printf("|   BMB   |");
+    for(int32_t i = 0; i < NUM_BMBS_IN_ACCUMULATOR; i++)
+    {
+        printf("    %02ld   |", i);
+    }
+    printf("\n");
+    for(int32_t i = 0; i < NUM_THERMISTORS_PER_BMB; i++)
+    {
+        printf("|    %02ld   |", i);
+        for(int32_t j = 0; j < NUM_BMBS_IN_ACCUMULATOR; j++)
+        {
+            if(gBms.telemetry.thermistorTemperatureValid[j] & (1UL << i))
+            {
+                printf("  %5.1f  |", gBms.telemetry.thermistorTemperature[j][i] / 10.0);
+            }
+            else if(gBms.telemetry.thermistorOpen[j] & (1UL << i))
+            {
+                printf("  OPEN   |");
+            }
+            else if(gBms.telemetry.thermistorShort[j] & (1UL << i))
+            {
+                printf("  SHORT  |");
+            }
+            else
+            {
+                printf("NO SIGNAL|");
+            }
+        }
+        printf("\n");
+    }
+}
@@ -0,0 +1,319 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include <stdbool.h>
+#include <string.h>
+#include "packStats.h"
+#include "bmb.h"
+
+// Packed 16-bit intrinsics on cores with the DSP extension
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include "stm32f4xx_hal.h"
+#define DSP_INSTRUCTIONS_AVAILABLE  1
+#else
+#define DSP_INSTRUCTIONS_AVAILABLE  0
+#endif
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Process two cells per instruction with packed 16-bit arithmetic. Defaults on when the core has the DSP
+// extension, and can be set to 1 elsewhere to check the packed path with emulated lanes
+#ifndef PACK_STATS_USE_SIMD
+#define PACK_STATS_USE_SIMD     DSP_INSTRUCTIONS_AVAILABLE
+#endif
+
+#if (NUM_CELLS_PER_BMB % 2) != 0
+#error "Packed statistics need an even number of cells per bmb"
+#endif
+
+#define ALL_CELLS_MASK      ((1UL << NUM_CELLS_PER_BMB) - 1)
+#define CELLS_PER_PAIR      2
+#define PAIRS_PER_BMB       (NUM_CELLS_PER_BMB / CELLS_PER_PAIR)
+
+// Fill values that never win a min or max, placed in the lanes of invalid cells
+#define EMPTY_MIN_PAIR      0x7FFF7FFFUL
+#define EMPTY_MAX_PAIR      0x80008000UL
+
+// Location of the running min and max before any cell is accumulated, after every real cell
+#define NO_CELL             0xFF
+
+// Orders cells by their position in the pack
+#define CELL_LOCATION(bmb, cell)    (((uint32_t)(bmb) << 8) | (cell))
+
+// Count the core cycles each scan spends accumulating the statistics with the DWT cycle counter, published with
+// the statistics so mainTask can check them against their CPU budget. Costs two counter reads per bmb
+#ifndef PACK_STATS_MEASURE_CYCLES
+#define PACK_STATS_MEASURE_CYCLES   1
+#endif
+
+#if PACK_STATS_MEASURE_CYCLES && DSP_INSTRUCTIONS_AVAILABLE
+#define CYCLE_COUNT()       (DWT->CYCCNT)
+#else
+#define CYCLE_COUNT()       (0UL)
+#endif
+
+#if PACK_STATS_USE_SIMD && DSP_INSTRUCTIONS_AVAILABLE
+#define MIN_PAIR(a, b)      dspMinPair((a), (b))
+#define MAX_PAIR(a, b)      dspMaxPair((a), (b))
+#define SUM_PAIR(a, sum)    ((int32_t)__SMLAD((a), 0x00010001UL, (uint32_t)(sum)))
+#elif PACK_STATS_USE_SIMD
+#define MIN_PAIR(a, b)      emulatedMinPair((a), (b))
+#define MAX_PAIR(a, b)      emulatedMaxPair((a), (b))
+#define SUM_PAIR(a, sum)    emulatedSumPair((a), (sum))
+#endif
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DECLARATIONS ==================== */
+/* ==================================================================== */
+
+static int32_t summarizeBmbCells(const int16_t *cells, uint32_t valid, int16_t *min, int16_t *max);
+static uint32_t findCell(const int16_t *cells, uint32_t valid, int16_t code);
+#if PACK_STATS_USE_SIMD && DSP_INSTRUCTIONS_AVAILABLE
+static inline uint32_t dspMinPair(uint32_t a, uint32_t b);
+static inline uint32_t dspMaxPair(uint32_t a, uint32_t b);
+#elif PACK_STATS_USE_SIMD
+static uint32_t emulatedMinPair(uint32_t a, uint32_t b);
+static uint32_t emulatedMaxPair(uint32_t a, uint32_t b);
+static int32_t emulatedSumPair(uint32_t a, int32_t sum);
+#endif
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+#if PACK_STATS_USE_SIMD
+
+/*!
+  @brief   Find the min, max and sum of the valid cells of a bmb, two cells at a time.
+  @param   cells - Cell voltage codes of the bmb.
+  @param   valid - Validity mask of the cells, with at least one bit set.
+  @param   min - Set to the lowest valid code.
+  @param   max - Set to the highest valid code.
+  @return  Sum of the valid codes.
+*/
+static int32_t summarizeBmbCells(const int16_t *cells, uint32_t valid, int16_t *min, int16_t *max)
+{
+    uint32_t minPair = EMPTY_MIN_PAIR;
+    uint32_t maxPair = EMPTY_MAX_PAIR;
+    int32_t sum = 0;
+
+    if(valid == ALL_CELLS_MASK)
+    {
+        // Every cell of a healthy bmb is valid, so no lanes need masking
+        for(uint32_t pair = 0; pair < PAIRS_PER_BMB; pair++)
+        {
+            uint32_t codes;
+            memcpy(&codes, &cells[pair * CELLS_PER_PAIR], sizeof(codes));
+            minPair = MIN_PAIR(minPair, codes);
+            maxPair = MAX_PAIR(maxPair, codes);
+            sum = SUM_PAIR(codes, sum);
+        }
+    }
+    else
+    {
+        // Lanes of invalid cells hold zero for the sum and a fill value that never wins the min or max
+        static const uint32_t laneMask[4] = { 0x00000000UL, 0x0000FFFFUL, 0xFFFF0000UL, 0xFFFFFFFFUL };
+        for(uint32_t pair = 0; pair < PAIRS_PER_BMB; pair++)
+        {
+            uint32_t codes;
+            memcpy(&codes, &cells[pair * CELLS_PER_PAIR], sizeof(codes));
+            uint32_t mask = laneMask[(valid >> (pair * CELLS_PER_PAIR)) & 0x3];
+            codes &= mask;
+            minPair = MIN_PAIR(minPair, codes | (EMPTY_MIN_PAIR & ~mask));
+            maxPair = MAX_PAIR(maxPair, codes | (EMPTY_MAX_PAIR & ~mask));
+            sum = SUM_PAIR(codes, sum);
+        }
+    }
+
+    int16_t minLow = (int16_t)(minPair & 0xFFFF);
+    int16_t minHigh = (int16_t)(minPair >> 16);
+    int16_t maxLow = (int16_t)(maxPair & 0xFFFF);
+    int16_t maxHigh = (int16_t)(maxPair >> 16);
+    *min = (minLow < minHigh) ? (minLow) : (minHigh);
+    *max = (maxLow > maxHigh) ? (maxLow) : (maxHigh);
+    return sum;
+}
+
+#else
+
+/*!
+  @brief   Find the min, max and sum of the valid cells of a bmb, one cell at a time.
+  @param   cells - Cell voltage codes of the bmb.
+  @param   valid - Validity mask of the cells, with at least one bit set.
+  @param   min - Set to the lowest valid code.
+  @param   max - Set to the highest valid code.
+  @return  Sum of the valid codes.
+*/
+static int32_t summarizeBmbCells(const int16_t *cells, uint32_t valid, int16_t *min, int16_t *max)
+{
+    int16_t lowest = INT16_MAX;
+    int16_t highest = INT16_MIN;
+    int32_t sum = 0;
+    for(uint32_t cell = 0; cell < NUM_CELLS_PER_BMB; cell++)
+    {
+        if(valid & (1UL << cell))
+        {
+            int16_t code = cells[cell];
+            lowest = (code < lowest) ? (code) : (lowest);
+            highest = (code > highest) ? (code) : (highest);
+            sum += code;
+        }
+    }
+
+    *min = lowest;
+    *max = highest;
+    return sum;
+}
+
+#endif
+
+/*!
+  @brief   Find the first valid cell of a bmb holding a code.
+  @param   cells - Cell voltage codes of the bmb.
+  @param   valid - Validity mask of the cells.
+  @param   code - Code to find, which a valid cell must hold.
+  @return  Index of the cell.
+*/
+static uint32_t findCell(const int16_t *cells, uint32_t valid, int16_t code)
+{
+    for(uint32_t cell = 0; cell < NUM_CELLS_PER_BMB; cell++)
+    {
+        if((valid & (1UL << cell)) && (cells[cell] == code))
+        {
+            return cell;
+        }
+    }
+    return 0;
+}
+
+#if PACK_STATS_USE_SIMD && DSP_INSTRUCTIONS_AVAILABLE
+
+// SSUB16 sets a greater-or-equal flag per halfword, which SEL then picks each lane with. Both sit in one asm
+// statement, so the compiler cannot schedule anything that touches the flags between them
+static inline uint32_t dspMinPair(uint32_t a, uint32_t b)
+{
+    uint32_t result;
+    __asm volatile ("ssub16 %0, %1, %2\n\tsel %0, %2, %1" : "=&r" (result) : "r" (a), "r" (b) : "cc");
+    return result;
+}
+
+static inline uint32_t dspMaxPair(uint32_t a, uint32_t b)
+{
+    uint32_t result;
+    __asm volatile ("ssub16 %0, %1, %2\n\tsel %0, %1, %2" : "=&r" (result) : "r" (a), "r" (b) : "cc");
+    return result;
+}
+
+#elif PACK_STATS_USE_SIMD
+
+static uint32_t emulatedMinPair(uint32_t a, uint32_t b)
+{
+    int16_t low = ((int16_t)(a & 0xFFFF) < (int16_t)(b & 0xFFFF)) ? ((int16_t)(a & 0xFFFF)) : ((int16_t)(b & 0xFFFF));
+    int16_t high = ((int16_t)(a >> 16) < (int16_t)(b >> 16)) ? ((int16_t)(a >> 16)) : ((int16_t)(b >> 16));
+    return ((uint32_t)(uint16_t)high << 16) | (uint16_t)low;
+}
+
+static uint32_t emulatedMaxPair(uint32_t a, uint32_t b)
+{
+    int16_t low = ((int16_t)(a & 0xFFFF) > (int16_t)(b & 0xFFFF)) ? ((int16_t)(a & 0xFFFF)) : ((int16_t)(b & 0xFFFF));
+    int16_t high = ((int16_t)(a >> 16) > (int16_t)(b >> 16)) ? ((int16_t)(a >> 16)) : ((int16_t)(b >> 16));
+    return ((uint32_t)(uint16_t)high << 16) | (uint16_t)low;
+}
+
+static int32_t emulatedSumPair(uint32_t a, int32_t sum)
+{
+    return sum + (int16_t)(a & 0xFFFF) + (int16_t)(a >> 16);
+}
+
+#endif
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+void resetPackStats(PackStatsAccumulator_S *scanStats)
+{
+#if PACK_STATS_MEASURE_CYCLES && DSP_INSTRUCTIONS_AVAILABLE
+    // The cycle counter only runs with trace enabled, and is left running once started
+    if(!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk))
+    {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+#endif
+    scanStats->cycles = 0;
+    scanStats->numValidCells = 0;
+    scanStats->sumCellVoltage = 0;
+    scanStats->minCellVoltage = INT16_MAX;
+    scanStats->maxCellVoltage = INT16_MIN;
+    scanStats->minCellBmb = NO_CELL;
+    scanStats->minCell = NO_CELL;
+    scanStats->maxCellBmb = NO_CELL;
+    scanStats->maxCell = NO_CELL;
+}
+
+void accumulatePackStats(PackStatsAccumulator_S *scanStats, uint32_t bmb, const int16_t *cells, uint32_t valid)
+{
+    uint32_t startCycles = CYCLE_COUNT();
+    valid &= ALL_CELLS_MASK;
+    if(valid == 0)
+    {
+        return;
+    }
+
+    int16_t min;
+    int16_t max;
+    scanStats->sumCellVoltage += summarizeBmbCells(cells, valid, &min, &max);
+    scanStats->numValidCells += (valid == ALL_CELLS_MASK) ? (NUM_CELLS_PER_BMB) : ((uint32_t)__builtin_popcount(valid));
+
+    // A register group read across the chain delivers later cells of earlier bmbs after earlier cells of later
+    // bmbs, so a tie only moves the location if it is earlier in the pack. The cell is only searched for then
+    if((min < scanStats->minCellVoltage) || ((min == scanStats->minCellVoltage) && (bmb <= scanStats->minCellBmb)))
+    {
+        uint32_t cell = findCell(cells, valid, min);
+        if((min < scanStats->minCellVoltage) ||
+           (CELL_LOCATION(bmb, cell) < CELL_LOCATION(scanStats->minCellBmb, scanStats->minCell)))
+        {
+            scanStats->minCellVoltage = min;
+            scanStats->minCellBmb = bmb;
+            scanStats->minCell = cell;
+        }
+    }
+    if((max > scanStats->maxCellVoltage) || ((max == scanStats->maxCellVoltage) && (bmb <= scanStats->maxCellBmb)))
+    {
+        uint32_t cell = findCell(cells, valid, max);
+        if((max > scanStats->maxCellVoltage) ||
+           (CELL_LOCATION(bmb, cell) < CELL_LOCATION(scanStats->maxCellBmb, scanStats->maxCell)))
+        {
+            scanStats->maxCellVoltage = max;
+            scanStats->maxCellBmb = bmb;
+            scanStats->maxCell = cell;
+        }
+    }
+    scanStats->cycles += CYCLE_COUNT() - startCycles;
+}
+
+void publishPackStats(const PackStatsAccumulator_S *scanStats, PackStats_S *stats)
+{
+    // Built aside and copied out whole, so the published statistics never mix two scans
+    PackStats_S published;
+    memset(&published, 0, sizeof(published));
+    if(scanStats->numValidCells > 0)
+    {
+        published.numValidCells = scanStats->numValidCells;
+        published.sumCellVoltage = scanStats->sumCellVoltage;
+        published.minCellVoltage = scanStats->minCellVoltage;
+        published.maxCellVoltage = scanStats->maxCellVoltage;
+        published.meanCellVoltage = (int16_t)(scanStats->sumCellVoltage / (int32_t)scanStats->numValidCells);
+        published.cellVoltageSpread = (uint16_t)(scanStats->maxCellVoltage - scanStats->minCellVoltage);
+        published.minCellBmb = scanStats->minCellBmb;
+        published.minCell = scanStats->minCell;
+        published.maxCellBmb = scanStats->maxCellBmb;
+        published.maxCell = scanStats->maxCell;
+    }
+    published.cycles = scanStats->cycles;
+    *stats = published;
+}
@@ -0,0 +1,194 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include "pec.h"
+#include "adbms6830.h"
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+#define CRC_LUT_SIZE            256
+
+// These crc values are left shifted 1 from the ADBMS6830 15bit crc
+// This prevents the need for a left shift after every crc calculation
+#define CRC_CMD_SEED            0x0020
+#define CRC_CMD_POLY            0x8B32
+#define CRC_CMD_SIZE            16
+
+#define CRC_DATA_SEED           0x0010
+#define CRC_DATA_POLY           0x008F
+#define CRC_DATA_SIZE           10
+
+// The 10bit data crc is held left aligned in 16 bits so two data bytes can be folded in per table lookup
+#define CRC_DATA_ALIGN_SHIFT    (BITS_IN_WORD - CRC_DATA_SIZE)
+#define CRC_DATA_ALIGNED_POLY   (CRC_DATA_POLY << CRC_DATA_ALIGN_SHIFT)
+
+// Single bit step of a left aligned crc
+#define CRC_SHIFT_BIT(crc, poly)    ((((crc) << 1) ^ (((crc) & 0x8000) ? (poly) : 0)) & 0xFFFF)
+
+// The crc is linear in its input, so each table entry is the xor of the entries for the bits set
+// in its index. basis##_n is the crc of the single bit n of the index
+#define CRC_TABLE_ENTRY(i, basis) \
+    ((((i) & 0x01) ? basis##_0 : 0) ^ (((i) & 0x02) ? basis##_1 : 0) ^ \
+     (((i) & 0x04) ? basis##_2 : 0) ^ (((i) & 0x08) ? basis##_3 : 0) ^ \
+     (((i) & 0x10) ? basis##_4 : 0) ^ (((i) & 0x20) ? basis##_5 : 0) ^ \
+     (((i) & 0x40) ? basis##_6 : 0) ^ (((i) & 0x80) ? basis##_7 : 0))
+
+#define CRC_TABLE_ROW(row, basis) \
+    CRC_TABLE_ENTRY((row) + 0x0, basis), CRC_TABLE_ENTRY((row) + 0x1, basis), CRC_TABLE_ENTRY((row) + 0x2, basis), CRC_TABLE_ENTRY((row) + 0x3, basis), \
+    CRC_TABLE_ENTRY((row) + 0x4, basis), CRC_TABLE_ENTRY((row) + 0x5, basis), CRC_TABLE_ENTRY((row) + 0x6, basis), CRC_TABLE_ENTRY((row) + 0x7, basis), \
+    CRC_TABLE_ENTRY((row) + 0x8, basis), CRC_TABLE_ENTRY((row) + 0x9, basis), CRC_TABLE_ENTRY((row) + 0xA, basis), CRC_TABLE_ENTRY((row) + 0xB, basis), \
+    CRC_TABLE_ENTRY((row) + 0xC, basis), CRC_TABLE_ENTRY((row) + 0xD, basis), CRC_TABLE_ENTRY((row) + 0xE, basis), CRC_TABLE_ENTRY((row) + 0xF, basis)
+
+#define CRC_TABLE(basis) \
+    CRC_TABLE_ROW(0x00, basis), CRC_TABLE_ROW(0x10, basis), CRC_TABLE_ROW(0x20, basis), CRC_TABLE_ROW(0x30, basis), \
+    CRC_TABLE_ROW(0x40, basis), CRC_TABLE_ROW(0x50, basis), CRC_TABLE_ROW(0x60, basis), CRC_TABLE_ROW(0x70, basis), \
+    CRC_TABLE_ROW(0x80, basis), CRC_TABLE_ROW(0x90, basis), CRC_TABLE_ROW(0xA0, basis), CRC_TABLE_ROW(0xB0, basis), \
+    CRC_TABLE_ROW(0xC0, basis), CRC_TABLE_ROW(0xD0, basis), CRC_TABLE_ROW(0xE0, basis), CRC_TABLE_ROW(0xF0, basis)
+
+// Datasheet examples used to confirm the polynomial definitions themselves
+#define PEC_SELF_TEST_COMMAND   0x0001
+#define PEC_SELF_TEST_CMD_PEC   0x3D6E
+
+/* ==================================================================== */
+/* ============================ CRC TABLES ============================ */
+/* ==================================================================== */
+
+// Byte index bit n lands in the top bit of the crc and is then shifted n + 1 more times.
+// Each step is derived from the previous one so the compiler evaluates a chain of 16 bit steps
+enum
+{
+    CMD_CRC_BIT_0 = CRC_SHIFT_BIT(0x8000, CRC_CMD_POLY),
+    CMD_CRC_BIT_1 = CRC_SHIFT_BIT(CMD_CRC_BIT_0, CRC_CMD_POLY),
+    CMD_CRC_BIT_2 = CRC_SHIFT_BIT(CMD_CRC_BIT_1, CRC_CMD_POLY),
+    CMD_CRC_BIT_3 = CRC_SHIFT_BIT(CMD_CRC_BIT_2, CRC_CMD_POLY),
+    CMD_CRC_BIT_4 = CRC_SHIFT_BIT(CMD_CRC_BIT_3, CRC_CMD_POLY),
+    CMD_CRC_BIT_5 = CRC_SHIFT_BIT(CMD_CRC_BIT_4, CRC_CMD_POLY),
+    CMD_CRC_BIT_6 = CRC_SHIFT_BIT(CMD_CRC_BIT_5, CRC_CMD_POLY),
+    CMD_CRC_BIT_7 = CRC_SHIFT_BIT(CMD_CRC_BIT_6, CRC_CMD_POLY),
+
+    DATA_CRC_BIT_0 = CRC_SHIFT_BIT(0x8000, CRC_DATA_ALIGNED_POLY),
+    DATA_CRC_BIT_1 = CRC_SHIFT_BIT(DATA_CRC_BIT_0, CRC_DATA_ALIGNED_POLY),
+    DATA_CRC_BIT_2 = CRC_SHIFT_BIT(DATA_CRC_BIT_1, CRC_DATA_ALIGNED_POLY),
+    DATA_CRC_BIT_3 = CRC_SHIFT_BIT(DATA_CRC_BIT_2, CRC_DATA_ALIGNED_POLY),
+    DATA_CRC_BIT_4 = CRC_SHIFT_BIT(DATA_CRC_BIT_3, CRC_DATA_ALIGNED_POLY),
+    DATA_CRC_BIT_5 = CRC_SHIFT_BIT(DATA_CRC_BIT_4, CRC_DATA_ALIGNED_POLY),
+    DATA_CRC_BIT_6 = CRC_SHIFT_BIT(DATA_CRC_BIT_5, CRC_DATA_ALIGNED_POLY),
+    DATA_CRC_BIT_7 = CRC_SHIFT_BIT(DATA_CRC_BIT_6, CRC_DATA_ALIGNED_POLY),
+
+    // The high table is followed by a zero byte, which is 8 more shifts
+    DATA_CRC_HIGH_BIT_0 = CRC_SHIFT_BIT(DATA_CRC_BIT_7, CRC_DATA_ALIGNED_POLY),
+    DATA_CRC_HIGH_BIT_1 = CRC_SHIFT_BIT(DATA_CRC_HIGH_BIT_0, CRC_DATA_ALIGNED_POLY),
+    DATA_CRC_HIGH_BIT_2 = CRC_SHIFT_BIT(DATA_CRC_HIGH_BIT_1, CRC_DATA_ALIGNED_POLY),
+    DATA_CRC_HIGH_BIT_3 = CRC_SHIFT_BIT(DATA_CRC_HIGH_BIT_2, CRC_DATA_ALIGNED_POLY),
+    DATA_CRC_HIGH_BIT_4 = CRC_SHIFT_BIT(DATA_CRC_HIGH_BIT_3, CRC_DATA_ALIGNED_POLY),
+    DATA_CRC_HIGH_BIT_5 = CRC_SHIFT_BIT(DATA_CRC_HIGH_BIT_4, CRC_DATA_ALIGNED_POLY),
+    DATA_CRC_HIGH_BIT_6 = CRC_SHIFT_BIT(DATA_CRC_HIGH_BIT_5, CRC_DATA_ALIGNED_POLY),
+    DATA_CRC_HIGH_BIT_7 = CRC_SHIFT_BIT(DATA_CRC_HIGH_BIT_6, CRC_DATA_ALIGNED_POLY)
+};
+
+static const uint16_t commandCrcTable[CRC_LUT_SIZE] = { CRC_TABLE(CMD_CRC_BIT) };
+
+// Left aligned crc of a single data byte
+static const uint16_t dataCrcTable[CRC_LUT_SIZE] = { CRC_TABLE(DATA_CRC_BIT) };
+
+// Left aligned crc of a data byte followed by a zero byte
+static const uint16_t dataCrcTableHigh[CRC_LUT_SIZE] = { CRC_TABLE(DATA_CRC_HIGH_BIT) };
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DECLARATIONS ==================== */
+/* ==================================================================== */
+
+static uint16_t calculateTableEntry(uint32_t index, uint32_t numShifts, uint16_t poly);
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+static uint16_t calculateTableEntry(uint32_t index, uint32_t numShifts, uint16_t poly)
+{
+    uint16_t crc = (uint16_t)(index << BITS_IN_BYTE);
+    for(int32_t i = 0; i < numShifts; i++)
+    {
+        crc = (crc & 0x8000) ? ((crc << 1) ^ poly) : (crc << 1);
+    }
+    return crc;
+}
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+uint16_t calculateCommandCrc(uint8_t *packet, uint32_t numBytes)
+{
+    // Begin crc calculation with intial value
+    uint16_t crc = CRC_CMD_SEED;
+
+    // For each byte of data, use lookup table to efficiently calculate crc
+    for(int32_t i = 0; i < numBytes; i++)
+    {
+        // Determine the next look up table index from the current crc and next data byte
+        uint8_t index = (uint8_t)((crc >> (CRC_CMD_SIZE - BITS_IN_BYTE)) ^ packet[i]);
+        
+        // Calculate the next intermediate crc from the current crc and look up table
+        crc = ((crc << BITS_IN_BYTE) ^ (uint16_t)(commandCrcTable[index]));
+    }
+
+    return crc;
+}
+
+void loadCommandFrame(uint16_t command, uint8_t *frame)
+{
+    // The crc of a command word is two table steps, so it is calculated per frame rather than cached
+    frame[0] = (uint8_t)(command >> BITS_IN_BYTE);
+    frame[1] = (uint8_t)(command);
+    uint16_t commandCrc = calculateCommandCrc(frame, COMMAND_SIZE_BYTES);
+    frame[2] = (uint8_t)(commandCrc >> BITS_IN_BYTE);
+    frame[3] = (uint8_t)(commandCrc);
+}
+
+uint16_t calculateDataCrc(uint8_t *packet, uint32_t numBytes, uint8_t commandCounter)
+{
+    // Begin crc calculation with the left aligned intial value
+    uint16_t crc = CRC_DATA_SEED << CRC_DATA_ALIGN_SHIFT;
+
+    // Fold two data bytes into the crc per step. The crc fits entirely inside the 16 bit slice,
+    // so the high byte is advanced through two bytes of shifting and the low byte through one
+    int32_t i = 0;
+    for(; (i + 1) < numBytes; i += BYTES_IN_WORD)
+    {
+        uint16_t slice = crc ^ (uint16_t)((packet[i] << BITS_IN_BYTE) | packet[i + 1]);
+        crc = dataCrcTableHigh[slice >> BITS_IN_BYTE] ^ dataCrcTable[slice & 0xFF];
+    }
+
+    // Odd length packets finish with a single byte step
+    if(i < numBytes)
+    {
+        crc = (crc << BITS_IN_BYTE) ^ dataCrcTable[(crc >> BITS_IN_BYTE) ^ packet[i]];
+    }
+
+    // Shift the 6 bit command counter through the crc. A 6 bit index only sees the last 6 steps
+    // of the byte table, so the same table can be used
+    crc = (crc << COMMAND_COUNTER_BITS) ^ dataCrcTable[(crc >> (BITS_IN_WORD - COMMAND_COUNTER_BITS)) ^ commandCounter];
+
+    return crc >> CRC_DATA_ALIGN_SHIFT;
+}
+
+bool pecSelfTest(void)
+{
+    // Compare every table entry against a bit at a time calculation from the polynomials
+    for(uint32_t i = 0; i < CRC_LUT_SIZE; i++)
+    {
+        if((commandCrcTable[i] != calculateTableEntry(i, BITS_IN_BYTE, CRC_CMD_POLY)) ||
+           (dataCrcTable[i] != calculateTableEntry(i, BITS_IN_BYTE, CRC_DATA_ALIGNED_POLY)) ||
+           (dataCrcTableHigh[i] != calculateTableEntry(i, BITS_IN_WORD, CRC_DATA_ALIGNED_POLY)))
+        {
+            return false;
+        }
+    }
+
+    // A table that matches the wrong polynomial would still pass the check above
+    uint8_t command[COMMAND_SIZE_BYTES] = {PEC_SELF_TEST_COMMAND >> BITS_IN_BYTE, PEC_SELF_TEST_COMMAND & 0xFF};
+    return (calculateCommandCrc(command, COMMAND_SIZE_BYTES) == PEC_SELF_TEST_CMD_PEC);
+}
@@ -0,0 +1,106 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include "thermistor.h"
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Aux results use the same code scale as the cell results
+#define AUX_ADC_RESOLUTION      0.00015
+#define AUX_ADC_OFFSET          1.5
+
+#define KELVIN_OFFSET           273.15
+
+// Interpolation slopes are 0.1 C per code in this many fractional bits
+#define SLOPE_FRACTION_BITS     16
+
+// exp(x) as a Taylor series the compiler evaluates. 24 terms keep double precision for |x| below 4,
+// which covers beta values up to 4500 over the table range
+#define EXP_TERM(x, n, rest)    (1.0 + (((x) / (n)) * (rest)))
+#define CONST_EXP(x) \
+    EXP_TERM(x, 1, EXP_TERM(x, 2, EXP_TERM(x, 3, EXP_TERM(x, 4, EXP_TERM(x, 5, EXP_TERM(x, 6, \
+    EXP_TERM(x, 7, EXP_TERM(x, 8, EXP_TERM(x, 9, EXP_TERM(x, 10, EXP_TERM(x, 11, EXP_TERM(x, 12, \
+    EXP_TERM(x, 13, EXP_TERM(x, 14, EXP_TERM(x, 15, EXP_TERM(x, 16, EXP_TERM(x, 17, EXP_TERM(x, 18, \
+    EXP_TERM(x, 19, EXP_TERM(x, 20, EXP_TERM(x, 21, EXP_TERM(x, 22, EXP_TERM(x, 23, EXP_TERM(x, 24, 1.0))))))))))))))))))))))))
+
+// Temperature in C at the start of table segment i
+#define SEGMENT_TEMPERATURE(i)  ((THERMISTOR_TABLE_MIN_DECI_C + ((i) * THERMISTOR_TABLE_STEP_DECI_C)) / 10.0)
+
+// Divider voltage Vs * R / (R + Rp), written as Vs / (1 + (Rp / R0) * exp(-B * (1 / T - 1 / T0))) so the
+// exponential is expanded once
+#define SEGMENT_VOLTS(i) \
+    (THERMISTOR_SUPPLY_VOLTS / (1.0 + ((THERMISTOR_PULLUP_OHMS / THERMISTOR_NOMINAL_OHMS) * \
+     CONST_EXP(-THERMISTOR_BETA * ((1.0 / (SEGMENT_TEMPERATURE(i) + KELVIN_OFFSET)) - \
+                                   (1.0 / (THERMISTOR_NOMINAL_C + KELVIN_OFFSET)))))))
+
+#define ROUND_TO_INT(x)         ((int32_t)(((x) >= 0) ? ((x) + 0.5) : ((x) - 0.5)))
+
+#define SEGMENT_CODE(i)         ROUND_TO_INT((SEGMENT_VOLTS(i) - AUX_ADC_OFFSET) / AUX_ADC_RESOLUTION)
+
+// Codes fall as the temperature rises, so the slope is the step over the code drop to the next segment
+#define SEGMENT_SLOPE(i) \
+    ROUND_TO_INT((THERMISTOR_TABLE_STEP_DECI_C * (double)(1UL << SLOPE_FRACTION_BITS)) / \
+                 (double)(SEGMENT_CODE(i) - SEGMENT_CODE((i) + 1)))
+
+#define SEGMENT(i)              { (int16_t)SEGMENT_CODE(i), (int32_t)SEGMENT_SLOPE(i) }
+
+#define SEGMENT_ROW(row) \
+    SEGMENT((row) + 0), SEGMENT((row) + 1), SEGMENT((row) + 2), SEGMENT((row) + 3), \
+    SEGMENT((row) + 4), SEGMENT((row) + 5), SEGMENT((row) + 6), SEGMENT((row) + 7)
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+typedef struct
+{
+    int16_t code;       // Code at the start of the segment
+    int32_t slope;      // 0.1 C per code the code falls below the start
+} ThermistorSegment_S;
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+// Segments in order of rising temperature and falling code
+static const ThermistorSegment_S thermistorTable[NUM_THERMISTOR_TABLE_SEGMENTS] =
+{
+    SEGMENT_ROW(0), SEGMENT_ROW(8), SEGMENT_ROW(16), SEGMENT_ROW(24),
+    SEGMENT_ROW(32), SEGMENT_ROW(40), SEGMENT_ROW(48), SEGMENT_ROW(56)
+};
+
+// Code at the hot end of the last segment
+static const int16_t thermistorTableEndCode = (int16_t)SEGMENT_CODE(NUM_THERMISTOR_TABLE_SEGMENTS);
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+THERMISTOR_STATUS_E thermistorCodeToTemperature(int16_t code, int16_t *temperature)
+{
+    // An open thermistor pulls its divider up to the supply, a short pulls it to ground
+    if(code > thermistorTable[0].code)
+    {
+        *temperature = THERMISTOR_TABLE_MIN_DECI_C;
+        return THERMISTOR_OPEN;
+    }
+    if(code < thermistorTableEndCode)
+    {
+        *temperature = THERMISTOR_TABLE_MAX_DECI_C;
+        return THERMISTOR_SHORT;
+    }
+
+    // Find the last segment starting at or above the code, with a fixed number of steps
+    uint32_t segment = 0;
+    for(uint32_t step = NUM_THERMISTOR_TABLE_SEGMENTS / 2; step > 0; step >>= 1)
+    {
+        segment += (code <= thermistorTable[segment + step].code) ? (step) : (0);
+    }
+
+    int32_t drop = thermistorTable[segment].code - code;
+    int32_t offset = ((drop * thermistorTable[segment].slope) + (1L << (SLOPE_FRACTION_BITS - 1))) >> SLOPE_FRACTION_BITS;
+    *temperature = (int16_t)(THERMISTOR_TABLE_MIN_DECI_C + (int32_t)(segment * THERMISTOR_TABLE_STEP_DECI_C) + offset);
+    return THERMISTOR_OK;
+}
@@ -0,0 +1,116 @@
+#ifndef INC_ADBMS6830SIM_H_
+#define INC_ADBMS6830SIM_H_
+
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+#define SIM_MAX_BMBS            64
+#define SIM_CELLS_PER_BMB       16
+
+// SPI1 runs from the 16MHz HSI with a /16 prescaler
+#define SIM_SPI_BIT_RATE_HZ     1000000
+
+// Approximate CS setup/hold and isoSPI turnaround added to every frame
+#define SIM_FRAME_OVERHEAD_US   2
+
+// Core clock used to turn estimated cycle counts into CPU load
+#define SIM_CPU_CLOCK_HZ        64000000
+
+// Time from ADC start command until results are written to the result registers
+#define SIM_CONVERSION_TIME_US  1000
+
+// Time for an aux conversion of every GPIO and module voltage
+#define SIM_AUX_CONVERSION_TIME_US  1500
+
+// Time for an aux conversion of V+ alone
+#define SIM_VPV_CONVERSION_TIME_US  200
+
+// Thermistors sit behind 4 channel muxes selected by GPO 9-10, whose outputs feed GPIO 1 and 2.
+// Thermistor n is read on GPIO (n % 2) + 1 with mux channel n / 2
+#define SIM_THERMISTOR_MUX_INPUTS   2
+#define SIM_THERMISTOR_MUX_CHANNELS 4
+#define SIM_THERMISTORS_PER_BMB     (SIM_THERMISTOR_MUX_INPUTS * SIM_THERMISTOR_MUX_CHANNELS)
+
+// A mux output still reads the previous channel until its filter settles after a channel change
+#define SIM_MUX_SETTLING_US     4000
+
+// Time for an S-ADC conversion with the open wire current on, which has to pull an open tap's filter down
+#define SIM_OPEN_WIRE_CONVERSION_TIME_US    2000
+
+// Die temperature each bmb powers up at, and the temperature an aux conversion must see to latch thermal shutdown
+#define SIM_DEFAULT_DIE_TEMPERATURE_C   30.0f
+#define SIM_THERMAL_SHUTDOWN_C          150.0f
+
+/* ==================================================================== */
+/* ========================= ENUMERATED TYPES========================== */
+/* ==================================================================== */
+
+typedef enum
+{
+    SIM_PORTA = 0,
+    SIM_PORTB,
+    SIM_NUM_PORTS
+} SIM_PORT_E;
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+// Bus activity accumulated since the last call to simResetStats
+typedef struct
+{
+    uint32_t frames;
+    uint32_t bytes;
+    uint32_t csTransitions;
+    uint64_t busTimeUs;
+    uint32_t commandPecErrors;
+    uint32_t dataPecErrors;
+    uint32_t interrupts;
+    uint64_t cpuCycles;
+
+    // Bus time of the open wire conversions, their polls and the S-ADC reads of their results
+    uint64_t openWireBusTimeUs;
+} SimStats_S;
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DECLARATIONS =================== */
+/* ==================================================================== */
+
+void simInit(uint32_t numBmbs);
+void simPowerOnReset(uint32_t bmb);
+void simSetCellVoltage(uint32_t bmb, uint32_t cell, float voltage);
+float simGetCellVoltage(uint32_t bmb, uint32_t cell);
+void simSetRedundantAdcError(uint32_t bmb, uint32_t cell, float error);
+void simSetOpenWire(uint32_t bmb, uint32_t tap, bool open);
+void simSetSumOfCellsError(uint32_t bmb, float error);
+void simSetDieTemperature(uint32_t bmb, float celsius);
+void simSetThermistorVoltage(uint32_t bmb, uint32_t thermistor, float voltage);
+float simGetThermistorVoltage(uint32_t bmb, uint32_t thermistor);
+void simCorruptReads(uint32_t bmb, uint16_t opcode, uint32_t numReads);
+void simDropCommands(uint32_t bmb, uint16_t opcode, uint32_t numCommands);
+void simSetReadErrorRate(float probability);
+void simBreakLink(uint32_t link);
+void simRepairLinks(void);
+uint8_t simGetCommandCounter(uint32_t bmb);
+
+void simSetChipSelect(SIM_PORT_E port, bool asserted);
+void simTransfer(const uint8_t *txData, uint8_t *rxData, uint32_t numBytes);
+
+uint64_t simGetTimeUs(void);
+void simAdvanceTimeUs(uint64_t us);
+
+void simChargeCpu(uint32_t interrupts, uint32_t cycles);
+void simResetStats(void);
+SimStats_S simGetStats(void);
+
+// Provided by the HAL stub
+const char* simGetSpiTransport(void);
+
+#endif /* INC_ADBMS6830SIM_H_ */
@@ -0,0 +1,37 @@
+#ifndef SIM_CMSIS_OS_H_
+#define SIM_CMSIS_OS_H_
+
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include <stdint.h>
+
+// Host stand-in for the FreeRTOS task API used by the bmb drivers
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdPASS                  (pdTRUE)
+#define pdFAIL                  (pdFALSE)
+
+#define portTICK_PERIOD_MS      ((TickType_t)1)
+
+/* ==================================================================== */
+/* ============================== TYPES =============================== */
+/* ==================================================================== */
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DECLARATIONS =================== */
+/* ==================================================================== */
+
+BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait);
+void vTaskDelay(const TickType_t xTicksToDelay);
+
+#endif /* SIM_CMSIS_OS_H_ */
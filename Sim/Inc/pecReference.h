@@ -0,0 +1,16 @@
+#ifndef INC_PECREFERENCE_H_
+#define INC_PECREFERENCE_H_
+
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include <stdint.h>
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DECLARATIONS =================== */
+/* ==================================================================== */
+
+uint16_t referenceCommandPec(const uint8_t *data, uint32_t numBytes);
+uint16_t referenceDataPec(const uint8_t *data, uint32_t numBytes, uint8_t commandCounter);
+
+#endif /* INC_PECREFERENCE_H_ */
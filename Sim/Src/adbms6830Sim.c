@@ -0,0 +1,1055 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include "adbms6830Sim.h"
+#include "pecReference.h"
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+#define SIM_COMMAND_BYTES       2
+#define SIM_PEC_BYTES           2
+#define SIM_COMMAND_PACKET_BYTES    (SIM_COMMAND_BYTES + SIM_PEC_BYTES)
+#define SIM_REGISTER_BYTES      6
+#define SIM_ALL_REGISTER_BYTES  32
+#define SIM_CELLS_PER_REG       3
+
+#define SIM_OPCODE_MASK         0x07FF
+#define SIM_IDLE_BYTE           0xFF
+
+#define SIM_COMMAND_COUNTER_BITS    6
+#define SIM_COMMAND_COUNTER_MAX     63
+
+// Result registers read back 0x8000 until the first conversion completes
+#define SIM_CLEARED_RESULT      0x8000
+
+#define SIM_ADC_RESOLUTION      0.00015f
+#define SIM_ADC_OFFSET          1.5f
+
+// ADCV is a family of opcodes: 0 1 RD CONT 1 1 DCP 0 RSTF OW[1:0]
+#define SIM_CMD_ADCV            0x0260
+#define SIM_ADCV_OPTION_MASK    0x0197
+#define SIM_ADCV_CONTINUOUS     0x0080
+#define SIM_ADCV_REDUNDANT      0x0100
+
+// ADSV is a family of opcodes: 0 0 1 CONT 1 1 DCP 1 0 OW[1:0]. OW 01 pulls down the even cell taps and 10 the odd ones
+#define SIM_CMD_ADSV            0x0168
+#define SIM_ADSV_OPTION_MASK    0x0093
+#define SIM_ADSV_OPEN_WIRE_MASK 0x0003
+#define SIM_ADSV_OPEN_WIRE_EVEN 0x0001
+#define SIM_ADSV_OPEN_WIRE_ODD  0x0002
+#define SIM_CMD_PLSADC          0x071D
+
+// Cell taps C0-C16, where cell n is measured between taps n and n + 1
+#define SIM_NUM_CELL_TAPS       (SIM_CELLS_PER_BMB + 1)
+
+// An open tap pulled down by the open wire current sinks to the tap below it, or this far below the bottom of the stack
+#define SIM_OPEN_WIRE_BOTTOM_DROP_V 1.0f
+
+// Seed for the read noise generator so noisy runs are repeatable
+#define SIM_NOISE_SEED          0x6830BEEF
+
+#define SIM_CMD_RSTCC           0x002E
+#define SIM_CMD_SNAP            0x002D
+#define SIM_CMD_UNSNAP          0x002F
+#define SIM_CMD_PLADC           0x0718
+#define SIM_CMD_SRST            0x0027
+#define SIM_CMD_CLOVUV          0x0715
+
+// ADAX is a family of opcodes: 1 0 OW PUP CH4 0 1 0 CH[3:0]
+#define SIM_CMD_ADAX            0x0410
+#define SIM_ADAX_OPTION_MASK    0x01CF
+#define SIM_ADAX_CH4_SHIFT      2
+#define SIM_ADAX_CH4_MASK       0x0040
+#define SIM_ADAX_CH_MASK        0x000F
+
+// ADAX channel converting V+ alone. Other single channels are not modelled and convert everything
+#define SIM_ADAX_CHANNEL_VPV    0x14
+#define SIM_CMD_PLAUX           0x071E
+
+// Aux register groups A-C hold GPIO 1-9, group D holds GPIO 10, VMV and V+
+#define SIM_NUM_GPIO            10
+#define SIM_NUM_AUX_RESULTS     12
+#define SIM_AUX_VMV             10
+#define SIM_AUX_VPV             11
+
+// The aux conversion also measures the internal voltages and die temperature of status groups A and B:
+// VREF2 and ITMP, then VD, VA and VRES
+#define SIM_NUM_STATUS_RESULTS  5
+#define SIM_STATUS_ITMP         1
+#define SIM_VREF2_V             3.0f
+#define SIM_VD_V                3.3f
+#define SIM_VA_V                5.0f
+#define SIM_VRES_V              1.8f
+
+// ITMP reads 7.5 mV per kelvin
+#define SIM_ITMP_VOLTS_PER_K    0.0075f
+#define SIM_KELVIN_OFFSET       273.0f
+
+// Thermal shutdown latches in bit 5 of status group C byte 5 until the device is reset
+#define SIM_STATC_FAULT_BYTE    5
+#define SIM_STATC_THSD          0x20
+
+// Config A resets with every GPO high, so no GPIO is pulled down, and the mux select lines on GPO 9-10
+#define SIM_DEFAULT_CFGA_0      0x01
+#define SIM_DEFAULT_CFGA_3      0xFF
+#define SIM_DEFAULT_CFGA_4      0x03
+#define SIM_MUX_SELECT_MASK     0x03
+
+// The GPO bits of config A read back the pin levels. A GPIO that is not pulled down reads high above this voltage,
+// and the mux select lines are pulled up
+#define SIM_GPIO_LOGIC_HIGH_V   2.0f
+
+// Cell comparator thresholds in config B are 12 bits, compared with the top 12 bits of each C-ADC result.
+// They reset to the extremes of the range, so no cell trips them
+#define SIM_THRESHOLD_SHIFT     4
+#define SIM_DEFAULT_CFGB_0      0x00
+#define SIM_DEFAULT_CFGB_1      0xF8
+#define SIM_DEFAULT_CFGB_2      0x7F
+
+/* ==================================================================== */
+/* ========================= ENUMERATED TYPES ========================= */
+/* ==================================================================== */
+
+typedef enum
+{
+    SIM_GROUP_CFGA = 0,
+    SIM_GROUP_CFGB,
+    SIM_GROUP_SID,
+    SIM_GROUP_CVA,
+    SIM_GROUP_CVB,
+    SIM_GROUP_CVC,
+    SIM_GROUP_CVD,
+    SIM_GROUP_CVE,
+    SIM_GROUP_CVF,
+    SIM_GROUP_ACA,
+    SIM_GROUP_ACB,
+    SIM_GROUP_ACC,
+    SIM_GROUP_ACD,
+    SIM_GROUP_ACE,
+    SIM_GROUP_ACF,
+    SIM_GROUP_SVA,
+    SIM_GROUP_SVB,
+    SIM_GROUP_SVC,
+    SIM_GROUP_SVD,
+    SIM_GROUP_SVE,
+    SIM_GROUP_SVF,
+    SIM_GROUP_STATA,
+    SIM_GROUP_STATB,
+    SIM_GROUP_STATC,
+    SIM_GROUP_STATD,
+    SIM_GROUP_AUXA,
+    SIM_GROUP_AUXB,
+    SIM_GROUP_AUXC,
+    SIM_GROUP_AUXD,
+    SIM_NUM_GROUPS
+} SIM_GROUP_E;
+
+typedef enum
+{
+    SIM_CMD_READ = 0,
+    SIM_CMD_WRITE
+} SIM_CMD_TYPE_E;
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+typedef struct
+{
+    uint16_t opcode;
+    SIM_CMD_TYPE_E type;
+    SIM_GROUP_E group;
+    uint32_t numBytes;
+} SimRegisterCommand_S;
+
+typedef struct
+{
+    uint8_t commandCounter;
+    uint8_t reg[SIM_NUM_GROUPS][SIM_REGISTER_BYTES];
+    float cellVoltage[SIM_CELLS_PER_BMB];
+    bool conversionPending;
+    bool conversionContinuous;
+    bool conversionCompleted;
+    uint64_t conversionDoneUs;
+    uint16_t conversionCodes[SIM_CELLS_PER_BMB];
+    uint16_t resultCodes[SIM_CELLS_PER_BMB];
+    bool conversionRedundant;
+    float redundantError[SIM_CELLS_PER_BMB];
+    float sumOfCellsError;
+
+    // S-ADC results, from redundant conversions alongside the C-ADC or from ADSV
+    uint16_t redundantConversionCodes[SIM_CELLS_PER_BMB];
+    uint16_t redundantResultCodes[SIM_CELLS_PER_BMB];
+    bool openTap[SIM_NUM_CELL_TAPS];
+    bool sAdcPending;
+    bool sAdcOpenWire;
+    uint64_t sAdcDoneUs;
+    float thermistorVoltage[SIM_THERMISTORS_PER_BMB];
+    uint32_t muxChannel;
+    uint32_t previousMuxChannel;
+    uint64_t muxSwitchUs;
+    bool auxPending;
+    bool auxVpvOnly;
+    uint64_t auxDoneUs;
+    uint16_t auxCodes[SIM_NUM_AUX_RESULTS];
+    uint16_t statusCodes[SIM_NUM_STATUS_RESULTS];
+    float dieTemperature;
+    bool resultsReady;
+    bool snapped;
+    uint16_t corruptOpcode;
+    uint32_t corruptReads;
+    uint16_t dropOpcode;
+    uint32_t dropCommands;
+} SimBmb_S;
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static const SimRegisterCommand_S registerCommands[] =
+{
+    { 0x0001, SIM_CMD_WRITE, SIM_GROUP_CFGA, SIM_REGISTER_BYTES },
+    { 0x0002, SIM_CMD_READ,  SIM_GROUP_CFGA, SIM_REGISTER_BYTES },
+    { 0x0024, SIM_CMD_WRITE, SIM_GROUP_CFGB, SIM_REGISTER_BYTES },
+    { 0x0026, SIM_CMD_READ,  SIM_GROUP_CFGB, SIM_REGISTER_BYTES },
+    { 0x002C, SIM_CMD_READ,  SIM_GROUP_SID,  SIM_REGISTER_BYTES },
+    { 0x0004, SIM_CMD_READ,  SIM_GROUP_CVA,  SIM_REGISTER_BYTES },
+    { 0x0006, SIM_CMD_READ,  SIM_GROUP_CVB,  SIM_REGISTER_BYTES },
+    { 0x0008, SIM_CMD_READ,  SIM_GROUP_CVC,  SIM_REGISTER_BYTES },
+    { 0x000A, SIM_CMD_READ,  SIM_GROUP_CVD,  SIM_REGISTER_BYTES },
+    { 0x0009, SIM_CMD_READ,  SIM_GROUP_CVE,  SIM_REGISTER_BYTES },
+    { 0x000B, SIM_CMD_READ,  SIM_GROUP_CVF,  SIM_REGISTER_BYTES },
+    { 0x0044, SIM_CMD_READ,  SIM_GROUP_ACA,  SIM_REGISTER_BYTES },
+    { 0x0046, SIM_CMD_READ,  SIM_GROUP_ACB,  SIM_REGISTER_BYTES },
+    { 0x0048, SIM_CMD_READ,  SIM_GROUP_ACC,  SIM_REGISTER_BYTES },
+    { 0x004A, SIM_CMD_READ,  SIM_GROUP_ACD,  SIM_REGISTER_BYTES },
+    { 0x0049, SIM_CMD_READ,  SIM_GROUP_ACE,  SIM_REGISTER_BYTES },
+    { 0x004B, SIM_CMD_READ,  SIM_GROUP_ACF,  SIM_REGISTER_BYTES },
+    { 0x0003, SIM_CMD_READ,  SIM_GROUP_SVA,  SIM_REGISTER_BYTES },
+    { 0x0005, SIM_CMD_READ,  SIM_GROUP_SVB,  SIM_REGISTER_BYTES },
+    { 0x0007, SIM_CMD_READ,  SIM_GROUP_SVC,  SIM_REGISTER_BYTES },
+    { 0x000D, SIM_CMD_READ,  SIM_GROUP_SVD,  SIM_REGISTER_BYTES },
+    { 0x000E, SIM_CMD_READ,  SIM_GROUP_SVE,  SIM_REGISTER_BYTES },
+    { 0x000F, SIM_CMD_READ,  SIM_GROUP_SVF,  SIM_REGISTER_BYTES },
+    { 0x0030, SIM_CMD_READ,  SIM_GROUP_STATA, SIM_REGISTER_BYTES },
+    { 0x0031, SIM_CMD_READ,  SIM_GROUP_STATB, SIM_REGISTER_BYTES },
+    { 0x0032, SIM_CMD_READ,  SIM_GROUP_STATC, SIM_REGISTER_BYTES },
+    { 0x0033, SIM_CMD_READ,  SIM_GROUP_STATD, SIM_REGISTER_BYTES },
+    { 0x0019, SIM_CMD_READ,  SIM_GROUP_AUXA, SIM_REGISTER_BYTES },
+    { 0x001A, SIM_CMD_READ,  SIM_GROUP_AUXB, SIM_REGISTER_BYTES },
+    { 0x001B, SIM_CMD_READ,  SIM_GROUP_AUXC, SIM_REGISTER_BYTES },
+    { 0x001F, SIM_CMD_READ,  SIM_GROUP_AUXD, SIM_REGISTER_BYTES },
+    { 0x000C, SIM_CMD_READ,  SIM_GROUP_CVA,  SIM_ALL_REGISTER_BYTES },
+    { 0x004C, SIM_CMD_READ,  SIM_GROUP_ACA,  SIM_ALL_REGISTER_BYTES },
+    { 0x0010, SIM_CMD_READ,  SIM_GROUP_SVA,  SIM_ALL_REGISTER_BYTES },
+};
+
+#define NUM_REGISTER_COMMANDS   (sizeof(registerCommands) / sizeof(registerCommands[0]))
+
+static SimBmb_S bmbs[SIM_MAX_BMBS];
+static uint32_t numSimBmbs;
+
+// Link 0 connects port A to bmb 0, link i connects bmb i-1 to bmb i, link N connects bmb N-1 to port B
+static bool linkBroken[SIM_MAX_BMBS + 1];
+
+static bool chipSelect[SIM_NUM_PORTS];
+
+static uint64_t simTimeUs;
+static SimStats_S stats;
+
+// Probability that any read packet picks up a bit error, scaled to the full 32 bit range
+static uint32_t readErrorThreshold;
+static uint32_t noiseState = SIM_NOISE_SEED;
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DECLARATIONS ==================== */
+/* ==================================================================== */
+
+static const SimRegisterCommand_S* findRegisterCommand(uint16_t opcode);
+static uint32_t getReachableBmbs(SIM_PORT_E port, uint32_t *order);
+static void incCommandCounter(SimBmb_S *bmb);
+static void writeCellResults(SimBmb_S *bmb, SIM_GROUP_E firstGroup, const uint16_t *codes);
+static void startConversion(SimBmb_S *bmb);
+static void latchResults(SimBmb_S *bmb);
+static int32_t signExtendThreshold(uint32_t threshold);
+static void compareCellLimits(SimBmb_S *bmb);
+static void updateConversion(SimBmb_S *bmb, uint64_t nowUs);
+static uint16_t voltsToCode(float voltage);
+static void writeAuxResults(SimBmb_S *bmb, const uint16_t *codes);
+static void writeStatusResults(SimBmb_S *bmb, const uint16_t *codes);
+static void startAuxConversion(SimBmb_S *bmb);
+static void updateAuxConversion(SimBmb_S *bmb, uint64_t nowUs);
+static void readGpioLevels(const SimBmb_S *bmb, uint8_t *config);
+static void updateMuxSelect(SimBmb_S *bmb);
+static void startOpenWireConversion(SimBmb_S *bmb, uint16_t openWire);
+static void updateSAdcConversion(SimBmb_S *bmb, uint64_t nowUs);
+static bool isOpenWireFrame(uint16_t opcode, const uint32_t *order, uint32_t numReachable);
+static void executeCommand(SimBmb_S *bmb, uint16_t opcode);
+static uint32_t nextNoise(void);
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+static const SimRegisterCommand_S* findRegisterCommand(uint16_t opcode)
+{
+    for(uint32_t i = 0; i < NUM_REGISTER_COMMANDS; i++)
+    {
+        if(registerCommands[i].opcode == opcode)
+        {
+            return &registerCommands[i];
+        }
+    }
+    return NULL;
+}
+
+static uint32_t getReachableBmbs(SIM_PORT_E port, uint32_t *order)
+{
+    // Walk away from the active port until the first broken link
+    uint32_t numReachable = 0;
+    for(uint32_t i = 0; i < numSimBmbs; i++)
+    {
+        uint32_t bmb = (port == SIM_PORTA) ? (i) : (numSimBmbs - i - 1);
+        uint32_t link = (port == SIM_PORTA) ? (bmb) : (bmb + 1);
+        if(linkBroken[link])
+        {
+            break;
+        }
+        order[numReachable++] = bmb;
+    }
+    return numReachable;
+}
+
+static void incCommandCounter(SimBmb_S *bmb)
+{
+    bmb->commandCounter++;
+    if(bmb->commandCounter > SIM_COMMAND_COUNTER_MAX)
+    {
+        bmb->commandCounter = 1;
+    }
+}
+
+static void writeCellResults(SimBmb_S *bmb, SIM_GROUP_E firstGroup, const uint16_t *codes)
+{
+    // Cell results are packed little endian, 3 cells per register, 1 cell in the final register
+    for(int32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+    {
+        uint8_t *reg = bmb->reg[firstGroup + (cell / SIM_CELLS_PER_REG)];
+        reg[(cell % SIM_CELLS_PER_REG) * 2] = (uint8_t)codes[cell];
+        reg[((cell % SIM_CELLS_PER_REG) * 2) + 1] = (uint8_t)(codes[cell] >> 8);
+    }
+}
+
+static void startConversion(SimBmb_S *bmb)
+{
+    // Results reflect the cell voltages when the conversion starts, whenever they are read back
+    for(int32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+    {
+        bmb->conversionCodes[cell] = (uint16_t)(int16_t)((bmb->cellVoltage[cell] - SIM_ADC_OFFSET) / SIM_ADC_RESOLUTION + 0.5f);
+
+        // The S-ADC only converts when the start command asks for a redundant measurement, otherwise its
+        // registers keep their last results
+        if(bmb->conversionRedundant)
+        {
+            float redundantVoltage = bmb->cellVoltage[cell] + bmb->redundantError[cell];
+            bmb->redundantConversionCodes[cell] = (uint16_t)(int16_t)((redundantVoltage - SIM_ADC_OFFSET) / SIM_ADC_RESOLUTION + 0.5f);
+        }
+    }
+}
+
+static void latchResults(SimBmb_S *bmb)
+{
+    memcpy(bmb->resultCodes, bmb->conversionCodes, sizeof(bmb->resultCodes));
+    if(bmb->conversionRedundant)
+    {
+        memcpy(bmb->redundantResultCodes, bmb->redundantConversionCodes, sizeof(bmb->redundantResultCodes));
+        bmb->sAdcOpenWire = false;
+    }
+    compareCellLimits(bmb);
+}
+
+static int32_t signExtendThreshold(uint32_t threshold)
+{
+    return (threshold & 0x800) ? ((int32_t)threshold - 0x1000) : ((int32_t)threshold);
+}
+
+static void compareCellLimits(SimBmb_S *bmb)
+{
+    // Every conversion checks each cell against both thresholds, flags latch in status D until CLOVUV
+    const uint8_t *cfgb = bmb->reg[SIM_GROUP_CFGB];
+    int32_t underThreshold = signExtendThreshold(cfgb[0] | ((uint32_t)(cfgb[1] & 0x0F) << 8));
+    int32_t overThreshold = signExtendThreshold((cfgb[1] >> 4) | ((uint32_t)cfgb[2] << 4));
+    for(int32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+    {
+        int32_t code = (int16_t)bmb->resultCodes[cell] >> SIM_THRESHOLD_SHIFT;
+        uint8_t *flags = &bmb->reg[SIM_GROUP_STATD][cell / 4];
+        *flags |= (uint8_t)(((code < underThreshold) ? (1) : (0)) << ((cell % 4) * 2));
+        *flags |= (uint8_t)(((code > overThreshold) ? (1) : (0)) << (((cell % 4) * 2) + 1));
+    }
+}
+
+static void updateConversion(SimBmb_S *bmb, uint64_t nowUs)
+{
+    if(bmb->conversionPending && (nowUs >= bmb->conversionDoneUs))
+    {
+        latchResults(bmb);
+        bmb->resultsReady = true;
+        bmb->conversionCompleted = true;
+
+        if(bmb->conversionContinuous)
+        {
+            // Every conversion after the first one started after the last cell voltage change
+            startConversion(bmb);
+            uint64_t extraConversions = (nowUs - bmb->conversionDoneUs) / SIM_CONVERSION_TIME_US;
+            bmb->conversionDoneUs += (extraConversions + 1) * SIM_CONVERSION_TIME_US;
+            if(extraConversions > 0)
+            {
+                latchResults(bmb);
+            }
+        }
+        else
+        {
+            bmb->conversionPending = false;
+        }
+    }
+
+    // A snapshot holds the result registers, completed conversions land once it is released
+    if(bmb->resultsReady && !bmb->snapped)
+    {
+        // Averaged results track the instantaneous results once the filter has settled
+        writeCellResults(bmb, SIM_GROUP_CVA, bmb->resultCodes);
+        writeCellResults(bmb, SIM_GROUP_ACA, bmb->resultCodes);
+        writeCellResults(bmb, SIM_GROUP_SVA, bmb->redundantResultCodes);
+        bmb->resultsReady = false;
+    }
+}
+
+static uint16_t voltsToCode(float voltage)
+{
+    // Rounded to nearest, since aux inputs can sit below the ADC offset
+    return (uint16_t)(int16_t)floorf(((voltage - SIM_ADC_OFFSET) / SIM_ADC_RESOLUTION) + 0.5f);
+}
+
+static void writeAuxResult(SimBmb_S *bmb, int32_t result, uint16_t code)
+{
+    // Aux results are packed little endian, 3 to a register, with the module voltages after GPIO 10
+    uint8_t *reg = bmb->reg[SIM_GROUP_AUXA + (result / 3)];
+    reg[(result % 3) * 2] = (uint8_t)code;
+    reg[((result % 3) * 2) + 1] = (uint8_t)(code >> 8);
+}
+
+static void writeAuxResults(SimBmb_S *bmb, const uint16_t *codes)
+{
+    for(int32_t i = 0; i < SIM_NUM_AUX_RESULTS; i++)
+    {
+        writeAuxResult(bmb, i, codes[i]);
+    }
+}
+
+static void writeStatusResults(SimBmb_S *bmb, const uint16_t *codes)
+{
+    // Packed little endian, VREF2 and ITMP in group A and VD, VA and VRES in group B
+    for(int32_t i = 0; i < SIM_NUM_STATUS_RESULTS; i++)
+    {
+        uint8_t *reg = (i < 2) ? (&bmb->reg[SIM_GROUP_STATA][i * 2]) : (&bmb->reg[SIM_GROUP_STATB][(i - 2) * 2]);
+        reg[0] = (uint8_t)codes[i];
+        reg[1] = (uint8_t)(codes[i] >> 8);
+    }
+}
+
+static void startAuxConversion(SimBmb_S *bmb)
+{
+    // A GPIO pulled down by its GPO reads 0V. A mux output reads the channel selected before
+    // the last change until it settles
+    uint32_t channel = ((simTimeUs - bmb->muxSwitchUs) >= SIM_MUX_SETTLING_US) ? (bmb->muxChannel) : (bmb->previousMuxChannel);
+    for(int32_t gpio = 0; gpio < SIM_NUM_GPIO; gpio++)
+    {
+        bool pulledDown = (gpio < 8) ? (!(bmb->reg[SIM_GROUP_CFGA][3] & (1 << gpio))) : (!(bmb->reg[SIM_GROUP_CFGA][4] & (1 << (gpio - 8))));
+        float voltage = 0.0f;
+        if(!pulledDown && (gpio < SIM_THERMISTOR_MUX_INPUTS))
+        {
+            voltage = bmb->thermistorVoltage[(channel * SIM_THERMISTOR_MUX_INPUTS) + gpio];
+        }
+        bmb->auxCodes[gpio] = voltsToCode(voltage);
+    }
+
+    // The module voltages are divided by 25 before conversion
+    float sum = 0.0f;
+    for(int32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+    {
+        sum += bmb->cellVoltage[cell];
+    }
+    bmb->auxCodes[SIM_AUX_VMV] = voltsToCode(0.0f);
+    bmb->auxCodes[SIM_AUX_VPV] = voltsToCode((sum + bmb->sumOfCellsError) / 25.0f);
+
+    bmb->statusCodes[0] = voltsToCode(SIM_VREF2_V);
+    bmb->statusCodes[SIM_STATUS_ITMP] = voltsToCode((bmb->dieTemperature + SIM_KELVIN_OFFSET) * SIM_ITMP_VOLTS_PER_K);
+    bmb->statusCodes[2] = voltsToCode(SIM_VD_V);
+    bmb->statusCodes[3] = voltsToCode(SIM_VA_V);
+    bmb->statusCodes[4] = voltsToCode(SIM_VRES_V);
+}
+
+static void updateAuxConversion(SimBmb_S *bmb, uint64_t nowUs)
+{
+    if(bmb->auxPending && bmb->auxVpvOnly && (nowUs >= bmb->auxDoneUs))
+    {
+        // Every other aux and status result keeps the last conversion that reached it
+        writeAuxResult(bmb, SIM_AUX_VPV, bmb->auxCodes[SIM_AUX_VPV]);
+        bmb->auxPending = false;
+    }
+    else if(bmb->auxPending && (nowUs >= bmb->auxDoneUs))
+    {
+        writeAuxResults(bmb, bmb->auxCodes);
+        writeStatusResults(bmb, bmb->statusCodes);
+        if(bmb->dieTemperature >= SIM_THERMAL_SHUTDOWN_C)
+        {
+            bmb->reg[SIM_GROUP_STATC][SIM_STATC_FAULT_BYTE] |= SIM_STATC_THSD;
+        }
+        bmb->auxPending = false;
+    }
+}
+
+static void readGpioLevels(const SimBmb_S *bmb, uint8_t *config)
+{
+    for(int32_t gpio = 0; gpio < SIM_THERMISTOR_MUX_INPUTS; gpio++)
+    {
+        if(bmb->thermistorVoltage[(bmb->muxChannel * SIM_THERMISTOR_MUX_INPUTS) + gpio] < SIM_GPIO_LOGIC_HIGH_V)
+        {
+            config[3] &= ~(1 << gpio);
+        }
+    }
+}
+
+static void updateMuxSelect(SimBmb_S *bmb)
+{
+    uint32_t channel = bmb->reg[SIM_GROUP_CFGA][4] & SIM_MUX_SELECT_MASK;
+    if(channel != bmb->muxChannel)
+    {
+        bmb->previousMuxChannel = bmb->muxChannel;
+        bmb->muxChannel = channel;
+        bmb->muxSwitchUs = simTimeUs;
+    }
+}
+
+static void startOpenWireConversion(SimBmb_S *bmb, uint16_t openWire)
+{
+    // The C-ADC taps float on their filters, so only the S-ADC sees an open tap, once the current pulls it down
+    float tapVoltage[SIM_NUM_CELL_TAPS];
+    tapVoltage[0] = 0.0f;
+    for(int32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+    {
+        tapVoltage[cell + 1] = tapVoltage[cell] + bmb->cellVoltage[cell];
+    }
+    for(int32_t tap = 0; tap < SIM_NUM_CELL_TAPS; tap++)
+    {
+        bool pulled = (tap % 2) ? ((openWire & SIM_ADSV_OPEN_WIRE_ODD) != 0) : ((openWire & SIM_ADSV_OPEN_WIRE_EVEN) != 0);
+        if(bmb->openTap[tap] && pulled)
+        {
+            tapVoltage[tap] = (tap > 0) ? (tapVoltage[tap - 1]) : (-SIM_OPEN_WIRE_BOTTOM_DROP_V);
+        }
+    }
+
+    for(int32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+    {
+        float voltage = tapVoltage[cell + 1] - tapVoltage[cell] + bmb->redundantError[cell];
+        bmb->redundantConversionCodes[cell] = voltsToCode(voltage);
+    }
+}
+
+static void updateSAdcConversion(SimBmb_S *bmb, uint64_t nowUs)
+{
+    if(bmb->sAdcPending && (nowUs >= bmb->sAdcDoneUs))
+    {
+        memcpy(bmb->redundantResultCodes, bmb->redundantConversionCodes, sizeof(bmb->redundantResultCodes));
+        bmb->sAdcPending = false;
+        bmb->resultsReady = true;
+        updateConversion(bmb, nowUs);
+    }
+}
+
+static bool isOpenWireFrame(uint16_t opcode, const uint32_t *order, uint32_t numReachable)
+{
+    if(((opcode & ~SIM_ADSV_OPTION_MASK) == SIM_CMD_ADSV) || (opcode == SIM_CMD_PLSADC))
+    {
+        return true;
+    }
+    if(numReachable == 0)
+    {
+        return false;
+    }
+
+    // C-ADC restarts that free the S-ADC for open wire conversions or hand it back afterwards, judged by the
+    // nearest bmb before the command runs, and S-ADC reads while it holds open wire results
+    const SimBmb_S *nearest = &bmbs[order[0]];
+    if((opcode & ~SIM_ADCV_OPTION_MASK) == SIM_CMD_ADCV)
+    {
+        return (opcode & SIM_ADCV_REDUNDANT) ? (nearest->sAdcOpenWire) : (nearest->conversionRedundant);
+    }
+    const SimRegisterCommand_S *registerCommand = findRegisterCommand(opcode);
+    return nearest->sAdcOpenWire && (registerCommand != NULL) &&
+           (registerCommand->group >= SIM_GROUP_SVA) && (registerCommand->group <= SIM_GROUP_SVF);
+}
+
+static void executeCommand(SimBmb_S *bmb, uint16_t opcode)
+{
+    if((opcode & ~SIM_ADCV_OPTION_MASK) == SIM_CMD_ADCV)
+    {
+        bmb->conversionPending = true;
+        bmb->conversionContinuous = ((opcode & SIM_ADCV_CONTINUOUS) != 0);
+        bmb->conversionRedundant = ((opcode & SIM_ADCV_REDUNDANT) != 0);
+        bmb->conversionCompleted = false;
+        bmb->conversionDoneUs = simTimeUs + SIM_CONVERSION_TIME_US;
+        startConversion(bmb);
+        incCommandCounter(bmb);
+    }
+    else if((opcode & ~SIM_ADSV_OPTION_MASK) == SIM_CMD_ADSV)
+    {
+        // The S-ADC leaves any redundant measurement for the new conversion
+        bmb->conversionRedundant = false;
+        bmb->sAdcPending = true;
+        bmb->sAdcOpenWire = ((opcode & SIM_ADSV_OPEN_WIRE_MASK) != 0);
+        bmb->sAdcDoneUs = simTimeUs + ((bmb->sAdcOpenWire) ? (SIM_OPEN_WIRE_CONVERSION_TIME_US) : (SIM_CONVERSION_TIME_US));
+        startOpenWireConversion(bmb, opcode & SIM_ADSV_OPEN_WIRE_MASK);
+        incCommandCounter(bmb);
+    }
+    else if((opcode & ~SIM_ADAX_OPTION_MASK) == SIM_CMD_ADAX)
+    {
+        // A new start abandons any conversion still running. A V+ conversion leaves the codes of the abandoned one
+        // unwritten, since only V+ is written when it finishes
+        uint32_t channel = ((opcode & SIM_ADAX_CH4_MASK) >> SIM_ADAX_CH4_SHIFT) | (opcode & SIM_ADAX_CH_MASK);
+        bmb->auxPending = true;
+        bmb->auxVpvOnly = (channel == SIM_ADAX_CHANNEL_VPV);
+        bmb->auxDoneUs = simTimeUs + ((bmb->auxVpvOnly) ? (SIM_VPV_CONVERSION_TIME_US) : (SIM_AUX_CONVERSION_TIME_US));
+        startAuxConversion(bmb);
+        incCommandCounter(bmb);
+    }
+    else if(opcode == SIM_CMD_RSTCC)
+    {
+        bmb->commandCounter = 0;
+    }
+    else if(opcode == SIM_CMD_SRST)
+    {
+        simPowerOnReset(bmb - bmbs);
+    }
+    else if(opcode == SIM_CMD_SNAP)
+    {
+        bmb->snapped = true;
+        incCommandCounter(bmb);
+    }
+    else if(opcode == SIM_CMD_CLOVUV)
+    {
+        memset(bmb->reg[SIM_GROUP_STATD], 0, 4);
+        incCommandCounter(bmb);
+    }
+    else if(opcode == SIM_CMD_UNSNAP)
+    {
+        bmb->snapped = false;
+        updateConversion(bmb, simTimeUs);
+        incCommandCounter(bmb);
+    }
+    else
+    {
+        // Unimplemented commands are accepted and counted so counter tracking remains consistent
+        incCommandCounter(bmb);
+    }
+}
+
+static uint32_t nextNoise(void)
+{
+    // xorshift32
+    noiseState ^= noiseState << 13;
+    noiseState ^= noiseState >> 17;
+    noiseState ^= noiseState << 5;
+    return noiseState;
+}
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+void simInit(uint32_t numBmbs)
+{
+    numSimBmbs = (numBmbs > SIM_MAX_BMBS) ? (SIM_MAX_BMBS) : (numBmbs);
+    simRepairLinks();
+    simSetReadErrorRate(0.0f);
+    noiseState = SIM_NOISE_SEED;
+    memset(chipSelect, 0, sizeof(chipSelect));
+    for(uint32_t i = 0; i < numSimBmbs; i++)
+    {
+        simPowerOnReset(i);
+
+        // Give every cell a distinct voltage so misplaced data is detectable
+        for(uint32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+        {
+            bmbs[i].cellVoltage[cell] = 3.6f + (0.001f * cell) + (0.02f * (i % 16));
+            bmbs[i].redundantError[cell] = 0.0f;
+        }
+        bmbs[i].sumOfCellsError = 0.0f;
+        memset(bmbs[i].openTap, 0, sizeof(bmbs[i].openTap));
+        bmbs[i].dieTemperature = SIM_DEFAULT_DIE_TEMPERATURE_C + (float)(i % 16);
+        for(uint32_t t = 0; t < SIM_THERMISTORS_PER_BMB; t++)
+        {
+            bmbs[i].thermistorVoltage[t] = 1.0f + (0.05f * t) + (0.01f * (i % 16));
+        }
+    }
+    simResetStats();
+}
+
+void simPowerOnReset(uint32_t bmb)
+{
+    if(bmb >= numSimBmbs)
+    {
+        return;
+    }
+
+    SimBmb_S *sim = &bmbs[bmb];
+    sim->commandCounter = 0;
+    sim->conversionPending = false;
+    sim->conversionContinuous = false;
+    sim->conversionRedundant = false;
+    sim->conversionCompleted = false;
+    sim->auxPending = false;
+    sim->sAdcPending = false;
+    sim->sAdcOpenWire = false;
+    sim->resultsReady = false;
+    sim->snapped = false;
+    sim->corruptReads = 0;
+    sim->dropCommands = 0;
+    memset(sim->reg, 0, sizeof(sim->reg));
+    sim->reg[SIM_GROUP_CFGB][0] = SIM_DEFAULT_CFGB_0;
+    sim->reg[SIM_GROUP_CFGB][1] = SIM_DEFAULT_CFGB_1;
+    sim->reg[SIM_GROUP_CFGB][2] = SIM_DEFAULT_CFGB_2;
+    sim->reg[SIM_GROUP_CFGA][0] = SIM_DEFAULT_CFGA_0;
+    sim->reg[SIM_GROUP_CFGA][3] = SIM_DEFAULT_CFGA_3;
+    sim->reg[SIM_GROUP_CFGA][4] = SIM_DEFAULT_CFGA_4;
+    updateMuxSelect(sim);
+
+    uint16_t cleared[SIM_CELLS_PER_BMB];
+    for(int32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+    {
+        cleared[cell] = SIM_CLEARED_RESULT;
+    }
+    writeCellResults(sim, SIM_GROUP_CVA, cleared);
+    writeCellResults(sim, SIM_GROUP_ACA, cleared);
+    writeCellResults(sim, SIM_GROUP_SVA, cleared);
+    uint16_t auxCleared[SIM_NUM_AUX_RESULTS];
+    for(int32_t i = 0; i < SIM_NUM_AUX_RESULTS; i++)
+    {
+        auxCleared[i] = SIM_CLEARED_RESULT;
+    }
+    writeAuxResults(sim, auxCleared);
+    writeStatusResults(sim, auxCleared);
+    memset(&sim->reg[SIM_GROUP_CVF][2], SIM_IDLE_BYTE, SIM_REGISTER_BYTES - 2);
+    memset(&sim->reg[SIM_GROUP_ACF][2], SIM_IDLE_BYTE, SIM_REGISTER_BYTES - 2);
+    memset(&sim->reg[SIM_GROUP_SVF][2], SIM_IDLE_BYTE, SIM_REGISTER_BYTES - 2);
+
+    // Serial ID is unique per device
+    for(int32_t i = 0; i < SIM_REGISTER_BYTES; i++)
+    {
+        sim->reg[SIM_GROUP_SID][i] = (uint8_t)(0xA0 + bmb + i);
+    }
+}
+
+void simSetCellVoltage(uint32_t bmb, uint32_t cell, float voltage)
+{
+    if((bmb < numSimBmbs) && (cell < SIM_CELLS_PER_BMB))
+    {
+        // Conversions finished so far saw the old voltage
+        updateConversion(&bmbs[bmb], simTimeUs);
+        bmbs[bmb].cellVoltage[cell] = voltage;
+    }
+}
+
+float simGetCellVoltage(uint32_t bmb, uint32_t cell)
+{
+    return bmbs[bmb].cellVoltage[cell];
+}
+
+void simSetOpenWire(uint32_t bmb, uint32_t tap, bool open)
+{
+    if((bmb < numSimBmbs) && (tap < SIM_NUM_CELL_TAPS))
+    {
+        bmbs[bmb].openTap[tap] = open;
+    }
+}
+
+void simSetSumOfCellsError(uint32_t bmb, float error)
+{
+    if(bmb < numSimBmbs)
+    {
+        bmbs[bmb].sumOfCellsError = error;
+    }
+}
+
+void simSetDieTemperature(uint32_t bmb, float celsius)
+{
+    if(bmb < numSimBmbs)
+    {
+        bmbs[bmb].dieTemperature = celsius;
+    }
+}
+
+void simSetThermistorVoltage(uint32_t bmb, uint32_t thermistor, float voltage)
+{
+    if((bmb < numSimBmbs) && (thermistor < SIM_THERMISTORS_PER_BMB))
+    {
+        bmbs[bmb].thermistorVoltage[thermistor] = voltage;
+    }
+}
+
+float simGetThermistorVoltage(uint32_t bmb, uint32_t thermistor)
+{
+    return bmbs[bmb].thermistorVoltage[thermistor];
+}
+
+void simSetRedundantAdcError(uint32_t bmb, uint32_t cell, float error)
+{
+    if((bmb < numSimBmbs) && (cell < SIM_CELLS_PER_BMB))
+    {
+        updateConversion(&bmbs[bmb], simTimeUs);
+        bmbs[bmb].redundantError[cell] = error;
+    }
+}
+
+void simCorruptReads(uint32_t bmb, uint16_t opcode, uint32_t numReads)
+{
+    if(bmb < numSimBmbs)
+    {
+        bmbs[bmb].corruptOpcode = opcode;
+        bmbs[bmb].corruptReads = numReads;
+    }
+}
+
+void simDropCommands(uint32_t bmb, uint16_t opcode, uint32_t numCommands)
+{
+    if(bmb < numSimBmbs)
+    {
+        bmbs[bmb].dropOpcode = opcode;
+        bmbs[bmb].dropCommands = numCommands;
+    }
+}
+
+void simSetReadErrorRate(float probability)
+{
+    probability = (probability < 0.0f) ? (0.0f) : ((probability > 1.0f) ? (1.0f) : (probability));
+    readErrorThreshold = (uint32_t)(probability * 4294967295.0);
+}
+
+void simBreakLink(uint32_t link)
+{
+    if(link <= numSimBmbs)
+    {
+        linkBroken[link] = true;
+    }
+}
+
+void simRepairLinks(void)
+{
+    memset(linkBroken, 0, sizeof(linkBroken));
+}
+
+uint8_t simGetCommandCounter(uint32_t bmb)
+{
+    return bmbs[bmb].commandCounter;
+}
+
+void simSetChipSelect(SIM_PORT_E port, bool asserted)
+{
+    if(chipSelect[port] != asserted)
+    {
+        stats.csTransitions++;
+    }
+    chipSelect[port] = asserted;
+}
+
+void simTransfer(const uint8_t *txData, uint8_t *rxData, uint32_t numBytes)
+{
+    // MISO idles high when no device drives the bus
+    memset(rxData, SIM_IDLE_BYTE, numBytes);
+
+    uint64_t frameStartUs = simTimeUs;
+    uint64_t frameTimeUs = SIM_FRAME_OVERHEAD_US + (((uint64_t)numBytes * 8 * 1000000) / SIM_SPI_BIT_RATE_HZ);
+    stats.frames++;
+    stats.bytes += numBytes;
+    stats.busTimeUs += frameTimeUs;
+    simTimeUs += frameTimeUs;
+
+    // Exactly one port must be selected for the chain to see the frame
+    if((chipSelect[SIM_PORTA] == chipSelect[SIM_PORTB]) || (numBytes < SIM_COMMAND_PACKET_BYTES))
+    {
+        return;
+    }
+    SIM_PORT_E port = (chipSelect[SIM_PORTA]) ? (SIM_PORTA) : (SIM_PORTB);
+
+    uint16_t commandPec = ((uint16_t)txData[2] << 8) | txData[3];
+    if(referenceCommandPec(txData, SIM_COMMAND_BYTES) != commandPec)
+    {
+        stats.commandPecErrors++;
+        return;
+    }
+    uint16_t opcode = (((uint16_t)txData[0] << 8) | txData[1]) & SIM_OPCODE_MASK;
+
+    uint32_t order[SIM_MAX_BMBS];
+    uint32_t numReachable = getReachableBmbs(port, order);
+    if(isOpenWireFrame(opcode, order, numReachable))
+    {
+        stats.openWireBusTimeUs += frameTimeUs;
+    }
+
+    if(opcode == SIM_CMD_PLSADC)
+    {
+        // Same as PLADC, for the S-ADC conversion
+        uint64_t pollUs = frameStartUs + ((SIM_COMMAND_PACKET_BYTES * 8 * 1000000) / SIM_SPI_BIT_RATE_HZ);
+        for(uint32_t pos = 0; pos < numReachable; pos++)
+        {
+            SimBmb_S *bmb = &bmbs[order[pos]];
+            updateSAdcConversion(bmb, pollUs);
+            if(bmb->sAdcPending)
+            {
+                memset(rxData + SIM_COMMAND_PACKET_BYTES, 0x00, numBytes - SIM_COMMAND_PACKET_BYTES);
+            }
+        }
+        return;
+    }
+
+    if(opcode == SIM_CMD_PLAUX)
+    {
+        // Same as PLADC, for the aux conversion
+        uint64_t pollUs = frameStartUs + ((SIM_COMMAND_PACKET_BYTES * 8 * 1000000) / SIM_SPI_BIT_RATE_HZ);
+        for(uint32_t pos = 0; pos < numReachable; pos++)
+        {
+            SimBmb_S *bmb = &bmbs[order[pos]];
+            updateAuxConversion(bmb, pollUs);
+            if(bmb->auxPending)
+            {
+                memset(rxData + SIM_COMMAND_PACKET_BYTES, 0x00, numBytes - SIM_COMMAND_PACKET_BYTES);
+            }
+        }
+        return;
+    }
+
+    if(opcode == SIM_CMD_PLADC)
+    {
+        // Polls do not count as commands. Any device that has not finished the conversion it was
+        // last started with holds SDO low for the rest of the frame
+        uint64_t pollUs = frameStartUs + ((SIM_COMMAND_PACKET_BYTES * 8 * 1000000) / SIM_SPI_BIT_RATE_HZ);
+        for(uint32_t pos = 0; pos < numReachable; pos++)
+        {
+            SimBmb_S *bmb = &bmbs[order[pos]];
+            updateConversion(bmb, pollUs);
+            if(bmb->conversionPending && !bmb->conversionCompleted)
+            {
+                memset(rxData + SIM_COMMAND_PACKET_BYTES, 0x00, numBytes - SIM_COMMAND_PACKET_BYTES);
+            }
+        }
+        return;
+    }
+
+    const SimRegisterCommand_S *registerCommand = findRegisterCommand(opcode);
+    uint32_t packetBytes = ((registerCommand != NULL) ? (registerCommand->numBytes) : (SIM_REGISTER_BYTES)) + SIM_PEC_BYTES;
+    uint32_t numPackets = (numBytes - SIM_COMMAND_PACKET_BYTES) / packetBytes;
+
+    for(uint32_t pos = 0; pos < numReachable; pos++)
+    {
+        SimBmb_S *bmb = &bmbs[order[pos]];
+
+        // Each device latches its result registers as its own packet starts shifting out
+        uint32_t bytesBeforeBmb = SIM_COMMAND_PACKET_BYTES + (((registerCommand != NULL) && (registerCommand->type == SIM_CMD_READ)) ? (pos * packetBytes) : (0));
+        updateConversion(bmb, frameStartUs + (((uint64_t)bytesBeforeBmb * 8 * 1000000) / SIM_SPI_BIT_RATE_HZ));
+        updateAuxConversion(bmb, frameStartUs + (((uint64_t)bytesBeforeBmb * 8 * 1000000) / SIM_SPI_BIT_RATE_HZ));
+        updateSAdcConversion(bmb, frameStartUs + (((uint64_t)bytesBeforeBmb * 8 * 1000000) / SIM_SPI_BIT_RATE_HZ));
+
+        if(registerCommand == NULL)
+        {
+            // A command lost on the way to the device is never executed or counted
+            if((bmb->dropCommands > 0) && (bmb->dropOpcode == opcode))
+            {
+                bmb->dropCommands--;
+                continue;
+            }
+            executeCommand(bmb, opcode);
+        }
+        else if(registerCommand->type == SIM_CMD_READ)
+        {
+            // The nearest device shifts its data out first
+            if(pos >= numPackets)
+            {
+                continue;
+            }
+            // Bulk reads span consecutive register groups
+            uint32_t dataBytes = registerCommand->numBytes;
+            uint8_t *packet = rxData + SIM_COMMAND_PACKET_BYTES + (pos * packetBytes);
+            memcpy(packet, bmb->reg[registerCommand->group], dataBytes);
+            if(registerCommand->group == SIM_GROUP_CFGA)
+            {
+                readGpioLevels(bmb, packet);
+            }
+            uint16_t dataPec = referenceDataPec(packet, dataBytes, bmb->commandCounter);
+            packet[dataBytes] = (uint8_t)((bmb->commandCounter << (8 - SIM_COMMAND_COUNTER_BITS)) | (dataPec >> 8));
+            packet[dataBytes + 1] = (uint8_t)dataPec;
+
+            // Flip a data bit after the PEC is calculated to emulate noise on the isoSPI link
+            if((bmb->corruptReads > 0) && (bmb->corruptOpcode == opcode))
+            {
+                bmb->corruptReads--;
+                packet[0] ^= 0x01;
+            }
+            else if((readErrorThreshold > 0) && (nextNoise() < readErrorThreshold))
+            {
+                packet[0] ^= 0x01;
+            }
+        }
+        else
+        {
+            // Write data shifts through the chain, so the first packet lands in the furthest device
+            if(pos >= numPackets)
+            {
+                continue;
+            }
+            const uint8_t *packet = txData + SIM_COMMAND_PACKET_BYTES + ((numPackets - pos - 1) * packetBytes);
+            uint16_t dataPec = (((uint16_t)packet[SIM_REGISTER_BYTES] << 8) | packet[SIM_REGISTER_BYTES + 1]) & 0x03FF;
+            if(referenceDataPec(packet, SIM_REGISTER_BYTES, 0) != dataPec)
+            {
+                stats.dataPecErrors++;
+                continue;
+            }
+            memcpy(bmb->reg[registerCommand->group], packet, SIM_REGISTER_BYTES);
+            if(registerCommand->group == SIM_GROUP_CFGA)
+            {
+                updateMuxSelect(bmb);
+            }
+            incCommandCounter(bmb);
+        }
+    }
+}
+
+uint64_t simGetTimeUs(void)
+{
+    return simTimeUs;
+}
+
+void simAdvanceTimeUs(uint64_t us)
+{
+    simTimeUs += us;
+}
+
+void simChargeCpu(uint32_t interrupts, uint32_t cycles)
+{
+    stats.interrupts += interrupts;
+    stats.cpuCycles += cycles;
+}
+
+void simResetStats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+SimStats_S simGetStats(void)
+{
+    return stats;
+}
@@ -0,0 +1,350 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "adbms6830.h"
+#include "bmb.h"
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+#define BENCH_NUM_PAYLOADS      4096
+#define BENCH_REPETITIONS       64
+
+// Hand-written float decode the firmware used before the register map and integer storage
+#define LEGACY_MAX_ADC_READING  0xFFFF
+#define LEGACY_RAILED_MARGIN    2500
+#define LEGACY_CLEARED_RESULT   0x8000
+#define LEGACY_RESOLUTION       0.00015f
+#define LEGACY_OFFSET           1.5f
+#define LEGACY_CELL_SIZE        2
+
+// Register data used by each row
+#define READ_VOLT_REG_ALL       0x004C
+#define READ_VOLT_REG_A         0x0044
+#define READ_AUX_REG_D          0x001F
+#define READ_STATUS_REG_A       0x0030
+#define READ_SADC_REG_ALL       0x0010
+
+// Redundant results further than this from the averaged cell voltage are mismatches, matching the
+// default tolerance of 25mV in bmb.c
+#define REDUNDANT_TOLERANCE     ((25 * 1000) / 150)
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+// Float and enum per result storage the firmware used before integer codes and validity masks
+typedef enum
+{
+    LEGACY_UNINITIALIZED = 0,
+    LEGACY_GOOD,
+    LEGACY_BAD
+} LEGACY_STATUS_E;
+
+typedef struct
+{
+    float value[NUM_CELLS_PER_BMB];
+    LEGACY_STATUS_E status[NUM_CELLS_PER_BMB];
+} LegacyResults_S;
+
+typedef struct
+{
+    const char *name;
+    uint16_t command;
+    uint32_t numBytes;
+    uint32_t numFields;
+    bool checkRailed;
+    void (*referenceFn)(PackTelemetry_S*, uint32_t, const uint8_t*);
+    uint8_t (*payloads)[ALL_REGISTER_SIZE_BYTES];
+} DecodeRow_S;
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DECLARATIONS ==================== */
+/* ==================================================================== */
+
+static uint32_t nextRandom(void);
+static uint16_t nextResultCode(void);
+static void legacyDecode(LegacyResults_S *results, const uint8_t *registerData, uint32_t numFields, bool checkRailed);
+static uint16_t readCode(const uint8_t *registerData, uint32_t field);
+static bool isReferenceRailed(uint16_t rawAdc);
+static void setValid(uint32_t *valid, uint32_t index, bool good);
+static void referenceDecodeBulk(PackTelemetry_S *pack, uint32_t bmb, const uint8_t *registerData);
+static void referenceDecodeGroupA(PackTelemetry_S *pack, uint32_t bmb, const uint8_t *registerData);
+static void referenceDecodeAuxD(PackTelemetry_S *pack, uint32_t bmb, const uint8_t *registerData);
+static void referenceDecodeStatusA(PackTelemetry_S *pack, uint32_t bmb, const uint8_t *registerData);
+static void referenceDecodeRedundantBulk(PackTelemetry_S *pack, uint32_t bmb, const uint8_t *registerData);
+static uint32_t verify(const DecodeRow_S *row);
+static double benchmark(const DecodeRow_S *row, uint32_t decoder);
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static uint8_t payloads[BENCH_NUM_PAYLOADS][ALL_REGISTER_SIZE_BYTES];
+static uint8_t redundantPayloads[BENCH_NUM_PAYLOADS][ALL_REGISTER_SIZE_BYTES];
+static uint32_t rngState = 0x6830A5A5;
+static PackTelemetry_S benchPack;
+static LegacyResults_S legacyResults;
+
+// Decoders compared by the benchmark
+enum
+{
+    DECODER_LEGACY_FLOAT = 0,
+    DECODER_REFERENCE,
+    DECODER_REGISTER_MAP
+};
+
+static const DecodeRow_S decodeRows[] =
+{
+    { "Cells, bulk",      READ_VOLT_REG_ALL, ALL_REGISTER_SIZE_BYTES, 16, true,  referenceDecodeBulk,          payloads },
+    { "Cells, group A",   READ_VOLT_REG_A,   REGISTER_SIZE_BYTES,     3,  true,  referenceDecodeGroupA,        payloads },
+    { "Aux, group D",     READ_AUX_REG_D,    REGISTER_SIZE_BYTES,     3,  false, referenceDecodeAuxD,          payloads },
+    { "Status, group A",  READ_STATUS_REG_A, REGISTER_SIZE_BYTES,     2,  false, referenceDecodeStatusA,       payloads },
+    { "Redundant, bulk",  READ_SADC_REG_ALL, ALL_REGISTER_SIZE_BYTES, 16, true,  referenceDecodeRedundantBulk, redundantPayloads },
+};
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+static uint32_t nextRandom(void)
+{
+    // xorshift32 keeps the payloads reproducible between runs
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static uint16_t nextResultCode(void)
+{
+    // Mostly in range results on either side of the offset, with some cleared ones and some near either rail
+    uint32_t choice = nextRandom() % 64;
+    if(choice == 0)
+    {
+        return LEGACY_CLEARED_RESULT;
+    }
+    else if(choice < 4)
+    {
+        return (uint16_t)(int16_t)(INT16_MIN + 1 + (int32_t)(nextRandom() % LEGACY_RAILED_MARGIN));
+    }
+    else if(choice < 8)
+    {
+        return (uint16_t)(int16_t)(INT16_MAX - (int32_t)(nextRandom() % LEGACY_RAILED_MARGIN));
+    }
+    return (uint16_t)(int16_t)((INT16_MIN + LEGACY_RAILED_MARGIN) + (int32_t)(nextRandom() % (UINT16_MAX - (2 * LEGACY_RAILED_MARGIN))));
+}
+
+static void legacyDecode(LegacyResults_S *results, const uint8_t *registerData, uint32_t numFields, bool checkRailed)
+{
+    for(uint32_t i = 0; i < numFields; i++)
+    {
+        uint16_t rawAdc = (registerData[(i * LEGACY_CELL_SIZE) + 1] << BITS_IN_BYTE) | registerData[i * LEGACY_CELL_SIZE];
+        if((rawAdc == LEGACY_CLEARED_RESULT) ||
+           (checkRailed && ((rawAdc < LEGACY_RAILED_MARGIN) || (rawAdc > (LEGACY_MAX_ADC_READING - LEGACY_RAILED_MARGIN)))))
+        {
+            results->status[i] = LEGACY_BAD;
+        }
+        else
+        {
+            results->value[i] = ((int16_t)rawAdc * LEGACY_RESOLUTION) + LEGACY_OFFSET;
+            results->status[i] = LEGACY_GOOD;
+        }
+    }
+}
+
+static uint16_t readCode(const uint8_t *registerData, uint32_t field)
+{
+    return (registerData[(field * LEGACY_CELL_SIZE) + 1] << BITS_IN_BYTE) | registerData[field * LEGACY_CELL_SIZE];
+}
+
+static bool isReferenceRailed(uint16_t rawAdc)
+{
+    // Results are signed codes around the 1.5 V offset, railed near either end of the int16_t range
+    return ((int16_t)rawAdc < (INT16_MIN + LEGACY_RAILED_MARGIN)) || ((int16_t)rawAdc > (INT16_MAX - LEGACY_RAILED_MARGIN));
+}
+
+static void setValid(uint32_t *valid, uint32_t index, bool good)
+{
+    *valid = (good) ? (*valid | (1UL << index)) : (*valid & ~(1UL << index));
+}
+
+static void referenceDecodeBulk(PackTelemetry_S *pack, uint32_t bmb, const uint8_t *registerData)
+{
+    for(int32_t cell = 0; cell < 16; cell++)
+    {
+        uint16_t rawAdc = readCode(registerData, cell);
+        pack->cellVoltage[bmb][cell] = (int16_t)rawAdc;
+        setValid(&pack->cellVoltageValid[bmb], cell, (rawAdc != LEGACY_CLEARED_RESULT) && !isReferenceRailed(rawAdc));
+    }
+}
+
+static void referenceDecodeGroupA(PackTelemetry_S *pack, uint32_t bmb, const uint8_t *registerData)
+{
+    for(int32_t cell = 0; cell < 3; cell++)
+    {
+        uint16_t rawAdc = readCode(registerData, cell);
+        pack->cellVoltage[bmb][cell] = (int16_t)rawAdc;
+        setValid(&pack->cellVoltageValid[bmb], cell, (rawAdc != LEGACY_CLEARED_RESULT) && !isReferenceRailed(rawAdc));
+    }
+}
+
+static void referenceDecodeAuxD(PackTelemetry_S *pack, uint32_t bmb, const uint8_t *registerData)
+{
+    pack->gpioVoltage[bmb][9] = (int16_t)readCode(registerData, 0);
+    setValid(&pack->gpioVoltageValid[bmb], 9, readCode(registerData, 0) != LEGACY_CLEARED_RESULT);
+    for(int32_t i = 0; i < NUM_MODULE_VOLTAGES; i++)
+    {
+        pack->moduleVoltage[bmb][i] = (int16_t)readCode(registerData, i + 1);
+        setValid(&pack->moduleVoltageValid[bmb], i, readCode(registerData, i + 1) != LEGACY_CLEARED_RESULT);
+    }
+}
+
+static void referenceDecodeStatusA(PackTelemetry_S *pack, uint32_t bmb, const uint8_t *registerData)
+{
+    pack->statusResult[bmb][STATUS_RESULT_VREF2] = (int16_t)readCode(registerData, 0);
+    setValid(&pack->statusResultValid[bmb], STATUS_RESULT_VREF2, readCode(registerData, 0) != LEGACY_CLEARED_RESULT);
+    pack->statusResult[bmb][STATUS_RESULT_ITMP] = (int16_t)readCode(registerData, 1);
+    setValid(&pack->statusResultValid[bmb], STATUS_RESULT_ITMP, readCode(registerData, 1) != LEGACY_CLEARED_RESULT);
+}
+
+static void referenceDecodeRedundantBulk(PackTelemetry_S *pack, uint32_t bmb, const uint8_t *registerData)
+{
+    for(int32_t cell = 0; cell < 16; cell++)
+    {
+        uint16_t rawAdc = readCode(registerData, cell);
+        pack->sAdcVoltage[bmb][cell] = (int16_t)rawAdc;
+        setValid(&pack->sAdcVoltageValid[bmb], cell, (rawAdc != LEGACY_CLEARED_RESULT) && !isReferenceRailed(rawAdc));
+
+        bool compared = (pack->cAdcVoltageValid[bmb] & pack->sAdcVoltageValid[bmb] & (1UL << cell)) != 0;
+        int32_t difference = pack->cAdcVoltage[bmb][cell] - pack->sAdcVoltage[bmb][cell];
+        setValid(&pack->redundantAdcMismatch[bmb], cell, compared && ((difference > REDUNDANT_TOLERANCE) ||
+                                                                      (difference < -REDUNDANT_TOLERANCE)));
+    }
+}
+
+static uint32_t verify(const DecodeRow_S *row)
+{
+    static PackTelemetry_S reference;
+    static PackTelemetry_S table;
+    memset(&reference, 0, sizeof(reference));
+    memset(&table, 0, sizeof(table));
+
+    // Every bmb starts with the same cell voltages, and the same C-ADC results the redundant results are checked against
+    for(uint32_t bmb = 0; bmb < NUM_BMBS_IN_ACCUMULATOR; bmb++)
+    {
+        referenceDecodeBulk(&reference, bmb, payloads[bmb]);
+        referenceDecodeBulk(&table, bmb, payloads[bmb]);
+    }
+    memcpy(reference.cAdcVoltage, reference.cellVoltage, sizeof(reference.cAdcVoltage));
+    memcpy(reference.cAdcVoltageValid, reference.cellVoltageValid, sizeof(reference.cAdcVoltageValid));
+    memcpy(&table, &reference, sizeof(PackTelemetry_S));
+
+    // Payloads are spread over the whole chain, so a write to the wrong bmb is caught as well
+    uint32_t mismatches = 0;
+    for(int32_t i = 0; i < BENCH_NUM_PAYLOADS; i++)
+    {
+        uint32_t bmb = i % NUM_BMBS_IN_ACCUMULATOR;
+        row->referenceFn(&reference, bmb, row->payloads[i]);
+        decodeRegisterGroup(&table, NULL, bmb, row->command, row->payloads[i]);
+        if(memcmp(&reference, &table, sizeof(PackTelemetry_S)) != 0)
+        {
+            mismatches++;
+            memcpy(&table, &reference, sizeof(PackTelemetry_S));
+        }
+    }
+    return mismatches;
+}
+
+static double benchmark(const DecodeRow_S *row, uint32_t decoder)
+{
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int32_t rep = 0; rep < BENCH_REPETITIONS; rep++)
+    {
+        for(int32_t i = 0; i < BENCH_NUM_PAYLOADS; i++)
+        {
+            uint32_t bmb = i % NUM_BMBS_IN_ACCUMULATOR;
+            if(decoder == DECODER_LEGACY_FLOAT)
+            {
+                legacyDecode(&legacyResults, row->payloads[i], row->numFields, row->checkRailed);
+            }
+            else if(decoder == DECODER_REFERENCE)
+            {
+                row->referenceFn(&benchPack, bmb, row->payloads[i]);
+            }
+            else
+            {
+                decodeRegisterGroup(&benchPack, NULL, bmb, row->command, row->payloads[i]);
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsedNs = ((end.tv_sec - start.tv_sec) * 1e9) + (end.tv_nsec - start.tv_nsec);
+    return elapsedNs / ((double)BENCH_REPETITIONS * BENCH_NUM_PAYLOADS);
+}
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+int main(void)
+{
+    for(int32_t i = 0; i < BENCH_NUM_PAYLOADS; i++)
+    {
+        for(int32_t j = 0; j < ALL_REGISTER_SIZE_BYTES; j += 2)
+        {
+            uint16_t code = nextResultCode();
+            payloads[i][j] = (uint8_t)code;
+            payloads[i][j + 1] = (uint8_t)(code >> BITS_IN_BYTE);
+        }
+    }
+
+    // Redundant results sit within twice the tolerance of the averaged results the verify starts each bmb with,
+    // so about half of them are mismatches
+    for(int32_t i = 0; i < BENCH_NUM_PAYLOADS; i++)
+    {
+        const uint8_t *averaged = payloads[i % NUM_BMBS_IN_ACCUMULATOR];
+        for(int32_t j = 0; j < ALL_REGISTER_SIZE_BYTES; j += 2)
+        {
+            uint16_t code = readCode(averaged, j / 2);
+            if((code != LEGACY_CLEARED_RESULT) && ((nextRandom() % 64) != 0))
+            {
+                code += (uint16_t)((nextRandom() % ((4 * REDUNDANT_TOLERANCE) + 1)) - (2 * REDUNDANT_TOLERANCE));
+            }
+            redundantPayloads[i][j] = (uint8_t)code;
+            redundantPayloads[i][j + 1] = (uint8_t)(code >> BITS_IN_BYTE);
+        }
+    }
+
+    uint32_t totalMismatches = 0;
+
+    printf("| Register group  | Bytes | Float decode (ns) | Hand-written (ns) | Register map (ns) | Mismatches |\n");
+    printf("|-----------------|-------|-------------------|-------------------|-------------------|------------|\n");
+    for(uint32_t i = 0; i < sizeof(decodeRows) / sizeof(decodeRows[0]); i++)
+    {
+        const DecodeRow_S *row = &decodeRows[i];
+        uint32_t mismatches = verify(row);
+        totalMismatches += mismatches;
+
+        double legacyNs = benchmark(row, DECODER_LEGACY_FLOAT);
+        double referenceNs = benchmark(row, DECODER_REFERENCE);
+        double tableNs = benchmark(row, DECODER_REGISTER_MAP);
+
+        printf("| %-15s | %5lu | %17.1f | %17.1f | %17.1f | %10lu |\n",
+               row->name, (unsigned long)row->numBytes, legacyNs, referenceNs, tableNs, (unsigned long)mismatches);
+    }
+    printf("Pack telemetry for %d bmbs: %lu bytes, float and enum cells per bmb: %lu bytes, integer cells per bmb: %lu bytes\n",
+           NUM_BMBS_IN_ACCUMULATOR, (unsigned long)sizeof(PackTelemetry_S), (unsigned long)sizeof(LegacyResults_S),
+           (unsigned long)(sizeof(benchPack.cellVoltage[0]) + sizeof(benchPack.cellVoltageValid[0])));
+    printf("(checksum %08X)\n", (unsigned int)((uint16_t)benchPack.cellVoltage[0][0] ^ benchPack.cellVoltageValid[0] ^
+                                               (uint32_t)(legacyResults.value[0] * 1000.0f)));
+
+    return (totalMismatches == 0) ? (0) : (1);
+}
@@ -0,0 +1,126 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include <stddef.h>
+#include <stdbool.h>
+#include "main.h"
+#include "spi.h"
+#include "adbms6830Sim.h"
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Estimated Cortex-M4 cycle costs of the HAL SPI paths, used to compare CPU load
+// Interrupt mode services a TXE and an RXNE interrupt for every byte
+#define SIM_IT_START_CYCLES         150
+#define SIM_IT_ISR_CYCLES           90
+#define SIM_IT_ISRS_PER_BYTE        2
+
+// DMA mode programs two streams, then takes an RX and a TX transfer complete interrupt
+#define SIM_DMA_START_CYCLES        450
+#define SIM_DMA_ISR_CYCLES          220
+#define SIM_DMA_ISRS_PER_FRAME      2
+
+/* ==================================================================== */
+/* ======================= EXTERNAL VARIABLES ========================= */
+/* ==================================================================== */
+
+GPIO_TypeDef simGpioA;
+GPIO_TypeDef simGpioB;
+GPIO_TypeDef simGpioC;
+
+SPI_HandleTypeDef hspi1;
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+// Notification value that the SPI complete interrupt would have posted to the main task
+static uint32_t pendingNotification = 0;
+
+static const char *spiTransport = "none";
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    if(PinState == GPIO_PIN_SET)
+    {
+        GPIOx->ODR |= GPIO_Pin;
+    }
+    else
+    {
+        GPIOx->ODR &= ~GPIO_Pin;
+    }
+
+    // Chip selects are active low
+    if((GPIOx == PORTA_CS_GPIO_Port) && (GPIO_Pin == PORTA_CS_Pin))
+    {
+        simSetChipSelect(SIM_PORTA, (PinState == GPIO_PIN_RESET));
+    }
+    else if((GPIOx == PORTB_CS_GPIO_Port) && (GPIO_Pin == PORTB_CS_Pin))
+    {
+        simSetChipSelect(SIM_PORTB, (PinState == GPIO_PIN_RESET));
+    }
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_IT(SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData, uint16_t Size)
+{
+    // The whole frame completes immediately and the TxRx complete callback is emulated
+    simTransfer(pTxData, pRxData, Size);
+    simChargeCpu(Size * SIM_IT_ISRS_PER_BYTE, SIM_IT_START_CYCLES + (Size * SIM_IT_ISRS_PER_BYTE * SIM_IT_ISR_CYCLES));
+    spiTransport = "IT";
+    pendingNotification |= SPI_SUCCESS;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData, uint16_t Size)
+{
+    simTransfer(pTxData, pRxData, Size);
+    simChargeCpu(SIM_DMA_ISRS_PER_FRAME, SIM_DMA_START_CYCLES + (SIM_DMA_ISRS_PER_FRAME * SIM_DMA_ISR_CYCLES));
+    spiTransport = "DMA";
+    pendingNotification |= SPI_SUCCESS;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort_IT(SPI_HandleTypeDef *hspi)
+{
+    pendingNotification = TASK_NO_OP;
+    return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)(simGetTimeUs() / 1000);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait)
+{
+    pendingNotification &= ~ulBitsToClearOnEntry;
+    if(pendingNotification == TASK_NO_OP)
+    {
+        // Nothing will ever arrive, so burn the full timeout
+        simAdvanceTimeUs((uint64_t)xTicksToWait * 1000);
+        return pdFALSE;
+    }
+
+    if(pulNotificationValue != NULL)
+    {
+        *pulNotificationValue = pendingNotification;
+    }
+    pendingNotification &= ~ulBitsToClearOnExit;
+    return pdTRUE;
+}
+
+const char* simGetSpiTransport(void)
+{
+    return spiTransport;
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    simAdvanceTimeUs((uint64_t)xTicksToDelay * portTICK_PERIOD_MS * 1000);
+}
@@ -0,0 +1,243 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "bmb.h"
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+#define BENCH_NUM_PACKS         256
+#define BENCH_REPETITIONS       64
+
+// Statistics run once per scan
+#define BENCH_SCAN_RATE_HZ      50
+
+// Cells in each register group when a bmb falls back to reading groups A-F one at a time across the chain
+#define BENCH_CELLS_PER_GROUP   3
+
+// Cell codes between 2.5V and 4.2V, with an occasional outlier at either end of the code range
+#define BENCH_MIN_CELL_CODE     6667
+#define BENCH_MAX_CELL_CODE     18000
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static PackTelemetry_S packs[BENCH_NUM_PACKS];
+static uint32_t rngState = 0x6830A5A5;
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DECLARATIONS ==================== */
+/* ==================================================================== */
+
+static uint32_t nextRandom(void);
+static void fillPack(PackTelemetry_S *pack);
+static void referencePackStats(const PackTelemetry_S *pack, uint32_t numBmbs, PackStats_S *stats);
+static void accumulateBulk(const PackTelemetry_S *pack, uint32_t numBmbs, PackStats_S *stats);
+static void accumulatePerRegister(const PackTelemetry_S *pack, uint32_t numBmbs, PackStats_S *stats);
+static bool matchesReference(const PackStats_S *stats, const PackStats_S *reference);
+static uint32_t verify(uint32_t numBmbs);
+static double benchmark(uint32_t numBmbs, int32_t *sink);
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+static uint32_t nextRandom(void)
+{
+    // xorshift32 keeps the packs reproducible between runs
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static void fillPack(PackTelemetry_S *pack)
+{
+    for(uint32_t bmb = 0; bmb < NUM_BMBS_IN_ACCUMULATOR; bmb++)
+    {
+        // Most bmbs are fully valid, some lose a few cells and a few are missing entirely
+        uint32_t choice = nextRandom() % 16;
+        uint32_t valid = (1UL << NUM_CELLS_PER_BMB) - 1;
+        if(choice == 0)
+        {
+            valid = 0;
+        }
+        else if(choice < 4)
+        {
+            valid &= nextRandom();
+        }
+        pack->cellVoltageValid[bmb] = valid;
+
+        for(uint32_t cell = 0; cell < NUM_CELLS_PER_BMB; cell++)
+        {
+            uint32_t outlier = nextRandom() % 256;
+            if(outlier == 0)
+            {
+                pack->cellVoltage[bmb][cell] = INT16_MIN;
+            }
+            else if(outlier == 1)
+            {
+                pack->cellVoltage[bmb][cell] = INT16_MAX;
+            }
+            else
+            {
+                // A narrow range makes ties common, which exercises the first-occurrence rule
+                pack->cellVoltage[bmb][cell] = (int16_t)(BENCH_MIN_CELL_CODE +
+                                                         (nextRandom() % (BENCH_MAX_CELL_CODE - BENCH_MIN_CELL_CODE)) / 64);
+            }
+        }
+    }
+}
+
+static void referencePackStats(const PackTelemetry_S *pack, uint32_t numBmbs, PackStats_S *stats)
+{
+    memset(stats, 0, sizeof(PackStats_S));
+    for(uint32_t bmb = 0; bmb < numBmbs; bmb++)
+    {
+        for(uint32_t cell = 0; cell < NUM_CELLS_PER_BMB; cell++)
+        {
+            if(!(pack->cellVoltageValid[bmb] & (1UL << cell)))
+            {
+                continue;
+            }
+
+            int16_t code = pack->cellVoltage[bmb][cell];
+            if((stats->numValidCells == 0) || (code < stats->minCellVoltage))
+            {
+                stats->minCellVoltage = code;
+                stats->minCellBmb = bmb;
+                stats->minCell = cell;
+            }
+            if((stats->numValidCells == 0) || (code > stats->maxCellVoltage))
+            {
+                stats->maxCellVoltage = code;
+                stats->maxCellBmb = bmb;
+                stats->maxCell = cell;
+            }
+            stats->sumCellVoltage += code;
+            stats->numValidCells++;
+        }
+    }
+
+    if(stats->numValidCells > 0)
+    {
+        stats->meanCellVoltage = (int16_t)(stats->sumCellVoltage / (int32_t)stats->numValidCells);
+        stats->cellVoltageSpread = (uint16_t)(stats->maxCellVoltage - stats->minCellVoltage);
+    }
+}
+
+static void accumulateBulk(const PackTelemetry_S *pack, uint32_t numBmbs, PackStats_S *stats)
+{
+    // Each bmb arrives whole, in chain order, like the bulk read
+    PackStatsAccumulator_S scanStats;
+    resetPackStats(&scanStats);
+    for(uint32_t bmb = 0; bmb < numBmbs; bmb++)
+    {
+        accumulatePackStats(&scanStats, bmb, pack->cellVoltage[bmb], pack->cellVoltageValid[bmb]);
+    }
+    publishPackStats(&scanStats, stats);
+}
+
+static void accumulatePerRegister(const PackTelemetry_S *pack, uint32_t numBmbs, PackStats_S *stats)
+{
+    // Each register group arrives for every bmb before the next group, like the per-register fallback
+    PackStatsAccumulator_S scanStats;
+    resetPackStats(&scanStats);
+    for(uint32_t first = 0; first < NUM_CELLS_PER_BMB; first += BENCH_CELLS_PER_GROUP)
+    {
+        uint32_t groupMask = ((1UL << BENCH_CELLS_PER_GROUP) - 1) << first;
+        for(uint32_t bmb = 0; bmb < numBmbs; bmb++)
+        {
+            accumulatePackStats(&scanStats, bmb, pack->cellVoltage[bmb], pack->cellVoltageValid[bmb] & groupMask);
+        }
+    }
+    publishPackStats(&scanStats, stats);
+}
+
+static bool matchesReference(const PackStats_S *stats, const PackStats_S *reference)
+{
+    return (stats->numValidCells == reference->numValidCells) && (stats->sumCellVoltage == reference->sumCellVoltage) &&
+           (stats->minCellVoltage == reference->minCellVoltage) && (stats->maxCellVoltage == reference->maxCellVoltage) &&
+           (stats->meanCellVoltage == reference->meanCellVoltage) && (stats->cellVoltageSpread == reference->cellVoltageSpread) &&
+           (stats->minCellBmb == reference->minCellBmb) && (stats->minCell == reference->minCell) &&
+           (stats->maxCellBmb == reference->maxCellBmb) && (stats->maxCell == reference->maxCell);
+}
+
+static uint32_t verify(uint32_t numBmbs)
+{
+    uint32_t mismatches = 0;
+    for(int32_t i = 0; i < BENCH_NUM_PACKS; i++)
+    {
+        PackStats_S reference;
+        PackStats_S stats;
+        referencePackStats(&packs[i], numBmbs, &reference);
+
+        memset(&stats, 0xA5, sizeof(stats));
+        accumulateBulk(&packs[i], numBmbs, &stats);
+        mismatches += matchesReference(&stats, &reference) ? (0) : (1);
+
+        memset(&stats, 0xA5, sizeof(stats));
+        accumulatePerRegister(&packs[i], numBmbs, &stats);
+        mismatches += matchesReference(&stats, &reference) ? (0) : (1);
+    }
+    return mismatches;
+}
+
+static double benchmark(uint32_t numBmbs, int32_t *sink)
+{
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int32_t rep = 0; rep < BENCH_REPETITIONS; rep++)
+    {
+        for(int32_t i = 0; i < BENCH_NUM_PACKS; i++)
+        {
+            PackStats_S stats;
+            accumulateBulk(&packs[i], numBmbs, &stats);
+            *sink += stats.sumCellVoltage + stats.minCell + stats.maxCellBmb;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsedNs = ((end.tv_sec - start.tv_sec) * 1e9) + (end.tv_nsec - start.tv_nsec);
+    return elapsedNs / ((double)BENCH_REPETITIONS * BENCH_NUM_PACKS);
+}
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+int main(int argc, char **argv)
+{
+    for(int32_t i = 0; i < BENCH_NUM_PACKS; i++)
+    {
+        fillPack(&packs[i]);
+    }
+
+    printf("Pack statistics (%s)\n", (argc > 1) ? (argv[1]) : ("scalar"));
+    printf("| BMBs | Cells | Time (ns) | Per cell (ns) | Host CPU at %d Hz (%%) | Mismatches |\n", BENCH_SCAN_RATE_HZ);
+    printf("|------|-------|-----------|---------------|------------------------|------------|\n");
+
+    const uint32_t chainLengths[] = { 1, 8, 16, 32, NUM_BMBS_IN_ACCUMULATOR };
+    uint32_t totalMismatches = 0;
+    int32_t sink = 0;
+    for(uint32_t i = 0; i < sizeof(chainLengths) / sizeof(chainLengths[0]); i++)
+    {
+        uint32_t numBmbs = chainLengths[i];
+        uint32_t mismatches = verify(numBmbs);
+        totalMismatches += mismatches;
+
+        double ns = benchmark(numBmbs, &sink);
+        printf("| %4lu | %5lu | %9.1f | %13.2f | %22.4f | %10lu |\n",
+               (unsigned long)numBmbs, (unsigned long)(numBmbs * NUM_CELLS_PER_BMB), ns, ns / (numBmbs * NUM_CELLS_PER_BMB),
+               (ns * BENCH_SCAN_RATE_HZ) / 1e7, (unsigned long)mismatches);
+    }
+    printf("(checksum %08X)\n", (unsigned int)sink);
+
+    return (totalMismatches == 0) ? (0) : (1);
+}
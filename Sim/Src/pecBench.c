@@ -0,0 +1,181 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include <stdio.h>
+#include <time.h>
+#include "adbms6830.h"
+#include "pec.h"
+#include "pecReference.h"
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+#define BENCH_NUM_PAYLOADS      4096
+#define BENCH_MAX_PAYLOAD_BYTES ALL_REGISTER_SIZE_BYTES
+#define BENCH_REPETITIONS       64
+
+// Byte-at-a-time implementation the firmware used before the sliced tables
+#define BYTEWISE_CRC_DATA_SEED  0x0010
+#define BYTEWISE_CRC_DATA_POLY  0x008F
+#define BYTEWISE_CRC_DATA_SIZE  10
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static uint8_t payloads[BENCH_NUM_PAYLOADS][BENCH_MAX_PAYLOAD_BYTES];
+static uint8_t commandCounters[BENCH_NUM_PAYLOADS];
+static uint16_t bytewiseTable[256];
+static uint32_t rngState = 0x6830A5A5;
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DECLARATIONS ==================== */
+/* ==================================================================== */
+
+static uint32_t nextRandom(void);
+static void buildBytewiseTable(void);
+static uint16_t bytewiseDataPec(const uint8_t *data, uint32_t numBytes, uint8_t commandCounter);
+static uint16_t slicedDataPec(const uint8_t *data, uint32_t numBytes, uint8_t commandCounter);
+static double benchmark(uint16_t (*pecFn)(const uint8_t*, uint32_t, uint8_t), uint32_t numBytes, uint16_t *sink);
+static uint32_t verify(uint32_t numBytes);
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+static uint32_t nextRandom(void)
+{
+    // xorshift32 keeps the payloads reproducible between runs
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static void buildBytewiseTable(void)
+{
+    for(uint32_t i = 0; i < 256; i++)
+    {
+        uint16_t crc = (uint16_t)(i << (BYTEWISE_CRC_DATA_SIZE - 8));
+        for(int32_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & (1 << (BYTEWISE_CRC_DATA_SIZE - 1))) ? ((crc << 1) ^ BYTEWISE_CRC_DATA_POLY) : (crc << 1);
+        }
+        bytewiseTable[i] = crc;
+    }
+}
+
+static uint16_t bytewiseDataPec(const uint8_t *data, uint32_t numBytes, uint8_t commandCounter)
+{
+    uint16_t crc = BYTEWISE_CRC_DATA_SEED;
+    for(uint32_t i = 0; i < numBytes; i++)
+    {
+        crc = (crc << 8) ^ bytewiseTable[(uint8_t)((crc >> (BYTEWISE_CRC_DATA_SIZE - 8)) ^ data[i])];
+    }
+    crc &= 0x03FF;
+    crc = (crc << COMMAND_COUNTER_BITS) ^ bytewiseTable[(uint8_t)((crc >> (BYTEWISE_CRC_DATA_SIZE - COMMAND_COUNTER_BITS)) ^ commandCounter)];
+    return crc & 0x03FF;
+}
+
+static uint16_t slicedDataPec(const uint8_t *data, uint32_t numBytes, uint8_t commandCounter)
+{
+    return calculateDataCrc((uint8_t*)data, numBytes, commandCounter);
+}
+
+static double benchmark(uint16_t (*pecFn)(const uint8_t*, uint32_t, uint8_t), uint32_t numBytes, uint16_t *sink)
+{
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int32_t rep = 0; rep < BENCH_REPETITIONS; rep++)
+    {
+        for(int32_t i = 0; i < BENCH_NUM_PAYLOADS; i++)
+        {
+            *sink ^= pecFn(payloads[i], numBytes, commandCounters[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsedNs = ((end.tv_sec - start.tv_sec) * 1e9) + (end.tv_nsec - start.tv_nsec);
+    return elapsedNs / ((double)BENCH_REPETITIONS * BENCH_NUM_PAYLOADS);
+}
+
+static uint32_t verify(uint32_t numBytes)
+{
+    uint32_t mismatches = 0;
+    for(int32_t i = 0; i < BENCH_NUM_PAYLOADS; i++)
+    {
+        uint16_t reference = referenceDataPec(payloads[i], numBytes, commandCounters[i]);
+        if((calculateDataCrc(payloads[i], numBytes, commandCounters[i]) != reference) ||
+           (bytewiseDataPec(payloads[i], numBytes, commandCounters[i]) != reference))
+        {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+int main(void)
+{
+    buildBytewiseTable();
+    for(int32_t i = 0; i < BENCH_NUM_PAYLOADS; i++)
+    {
+        for(int32_t j = 0; j < BENCH_MAX_PAYLOAD_BYTES; j++)
+        {
+            payloads[i][j] = (uint8_t)nextRandom();
+        }
+        commandCounters[i] = (uint8_t)(nextRandom() & 0x3F);
+    }
+
+    bool selfTestPassed = pecSelfTest();
+    printf("PEC self test: %s\n", selfTestPassed ? "passed" : "FAILED");
+
+    // Command PECs are checked over every possible command word
+    uint32_t commandMismatches = 0;
+    for(uint32_t command = 0; command <= 0xFFFF; command++)
+    {
+        uint8_t word[COMMAND_SIZE_BYTES] = { (uint8_t)(command >> 8), (uint8_t)command };
+        uint16_t reference = referenceCommandPec(word, COMMAND_SIZE_BYTES);
+        if(calculateCommandCrc(word, COMMAND_SIZE_BYTES) != reference)
+        {
+            commandMismatches++;
+        }
+
+        // Frames must carry the same command word and PEC
+        uint8_t frame[COMMAND_PACKET_LENGTH];
+        loadCommandFrame((uint16_t)command, frame);
+        if((frame[0] != word[0]) || (frame[1] != word[1]) || (((frame[2] << BITS_IN_BYTE) | frame[3]) != reference))
+        {
+            commandMismatches++;
+        }
+    }
+    printf("Command PEC: %lu mismatches over all 65536 command words\n\n", (unsigned long)commandMismatches);
+
+    const uint32_t payloadSizes[] = { REGISTER_SIZE_BYTES, ALL_REGISTER_SIZE_BYTES };
+    uint32_t totalMismatches = commandMismatches;
+    uint16_t sink = 0;
+
+    printf("| Payload (bytes) | Bitwise (ns) | Bytewise (ns) | Sliced (ns) | Speedup vs bytewise | Mismatches |\n");
+    printf("|-----------------|--------------|---------------|-------------|---------------------|------------|\n");
+    for(uint32_t i = 0; i < sizeof(payloadSizes) / sizeof(payloadSizes[0]); i++)
+    {
+        uint32_t numBytes = payloadSizes[i];
+        uint32_t mismatches = verify(numBytes);
+        totalMismatches += mismatches;
+
+        double bitwiseNs = benchmark(referenceDataPec, numBytes, &sink);
+        double bytewiseNs = benchmark(bytewiseDataPec, numBytes, &sink);
+        double slicedNs = benchmark(slicedDataPec, numBytes, &sink);
+
+        printf("| %15lu | %12.1f | %13.1f | %11.1f | %18.2fx | %10lu |\n",
+               (unsigned long)numBytes, bitwiseNs, bytewiseNs, slicedNs, bytewiseNs / slicedNs, (unsigned long)mismatches);
+    }
+    printf("(checksum %04X)\n", sink);
+
+    return ((totalMismatches == 0) && selfTestPassed) ? (0) : (1);
+}
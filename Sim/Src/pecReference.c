@@ -0,0 +1,73 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include "pecReference.h"
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Bitwise PEC definitions taken directly from the ADBMS6830 datasheet
+// These are deliberately independent of the lookup tables used by the firmware
+#define REF_CRC_CMD_SEED        0x0010
+#define REF_CRC_CMD_POLY        0x4599
+#define REF_CRC_CMD_BITS        15
+
+#define REF_CRC_DATA_SEED       0x0010
+#define REF_CRC_DATA_POLY       0x008F
+#define REF_CRC_DATA_BITS       10
+
+#define REF_COMMAND_COUNTER_BITS    6
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+uint16_t referenceCommandPec(const uint8_t *data, uint32_t numBytes)
+{
+    uint16_t pec = REF_CRC_CMD_SEED;
+    for(uint32_t i = 0; i < numBytes; i++)
+    {
+        for(int32_t bit = 7; bit >= 0; bit--)
+        {
+            uint16_t in = ((data[i] >> bit) & 1) ^ ((pec >> (REF_CRC_CMD_BITS - 1)) & 1);
+            pec = (pec << 1) & ((1 << REF_CRC_CMD_BITS) - 1);
+            if(in)
+            {
+                pec ^= REF_CRC_CMD_POLY;
+            }
+        }
+    }
+
+    // The transmitted PEC is the 15 bit crc with a zero appended as the LSB
+    return (uint16_t)(pec << 1);
+}
+
+uint16_t referenceDataPec(const uint8_t *data, uint32_t numBytes, uint8_t commandCounter)
+{
+    uint16_t pec = REF_CRC_DATA_SEED;
+    for(uint32_t i = 0; i < numBytes; i++)
+    {
+        for(int32_t bit = 7; bit >= 0; bit--)
+        {
+            uint16_t in = ((data[i] >> bit) & 1) ^ ((pec >> (REF_CRC_DATA_BITS - 1)) & 1);
+            pec = (pec << 1) & ((1 << REF_CRC_DATA_BITS) - 1);
+            if(in)
+            {
+                pec ^= REF_CRC_DATA_POLY;
+            }
+        }
+    }
+
+    // The 6 bit command counter is shifted through the crc after the data
+    for(int32_t bit = REF_COMMAND_COUNTER_BITS - 1; bit >= 0; bit--)
+    {
+        uint16_t in = ((commandCounter >> bit) & 1) ^ ((pec >> (REF_CRC_DATA_BITS - 1)) & 1);
+        pec = (pec << 1) & ((1 << REF_CRC_DATA_BITS) - 1);
+        if(in)
+        {
+            pec ^= REF_CRC_DATA_POLY;
+        }
+    }
+    return pec;
+}
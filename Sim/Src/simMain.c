@@ -0,0 +1,1303 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "bmb.h"
+#include "adbms6830Sim.h"
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Mirrors BMB_MIN_UPDATE_PERIOD_MS in bms.c
+#define SIM_SCAN_PERIOD_US      50000
+
+// Time between conversion polls while updatePackTelemetry waits for a scan, and the most polls
+// before scanning anyway
+#define SIM_POLL_INTERVAL_US    100
+#define SIM_MAX_POLLS           100
+
+#define SIM_WARMUP_SCANS        4
+#define SIM_MEASURED_SCANS      16
+
+// Decoded voltages must land within one ADC code of the simulated value
+#define SIM_VOLTAGE_TOLERANCE   0.0002f
+
+// Fault scenario: corrupt enough bulk reads from one bmb to exhaust every driver retry
+#define SIM_FAULT_CHAIN_LENGTH  16
+#define SIM_FAULT_BMB           7
+#define SIM_FAULT_READS         6
+#define READ_VOLT_REG_ALL       0x004C
+
+// Snapshot scenario: a bmb that misses the release stays frozen on an old conversion
+#define CMD_RELEASE_SNAPSHOT    0x002F
+#define SIM_COHERENCE_GENERATIONS   3
+
+// Cell limit scenario: mirrors the limits and flag poll period in bms.c, then pushes one cell of the
+// fault bmb past each limit
+#define SIM_FLAG_POLL_PERIOD_US     5000
+#define SIM_UNDERVOLTAGE_LIMIT_V    2.5f
+#define SIM_OVERVOLTAGE_LIMIT_V     4.2f
+#define SIM_OVERVOLTAGE_CELL        5
+#define SIM_UNDERVOLTAGE_CELL       11
+#define SIM_LIMIT_MAX_SCANS         2
+
+// Redundant ADC scenario: one cell's S-ADC reads well outside the C-ADC tolerance, its neighbour just inside it
+#define SIM_REDUNDANT_CELL          3
+#define SIM_REDUNDANT_FAULT_V       0.05f
+#define SIM_REDUNDANT_DRIFT_V       0.02f
+
+// Scans for the redundant check to cover every cell when it reads one S-ADC register group per scan
+#define SIM_REDUNDANT_ROTATION_SCANS    6
+
+// Open wire scenario: mirrors BMB_OPEN_WIRE_BUS_PERCENT in bmb.c. At that share a check of the fault chain holds
+// the S-ADC for up to this many scans, which pauses the redundant check, and the next check starts once the
+// redundant check has covered every cell again
+#define SIM_OPEN_WIRE_BUS_PERCENT   2
+#define SIM_OPEN_WIRE_HOLD_SCANS    36
+#define SIM_OPEN_WIRE_PERIOD_SCANS  (SIM_OPEN_WIRE_HOLD_SCANS + SIM_REDUNDANT_ROTATION_SCANS)
+
+// Scans for the redundant check to cover every cell, when an open wire check may hold the S-ADC first
+#define SIM_REDUNDANT_DETECTION_SCANS   (SIM_REDUNDANT_ROTATION_SCANS + SIM_OPEN_WIRE_HOLD_SCANS)
+
+// Bus share the open wire check may use over its budget, from the one step the budget can save up
+#define SIM_OPEN_WIRE_SLACK_PERCENT 0.1
+
+// Taps left open: a middle tap of the fault bmb, which cells 4 and 5 share, and the top and bottom taps of
+// two other bmbs, which only cells 15 and 0 use
+#define SIM_OPEN_WIRE_TAP           5
+#define SIM_OPEN_WIRE_TOP_BMB       3
+#define SIM_OPEN_WIRE_BOTTOM_BMB    12
+
+// Thermistor scenario: scans allowed for every mux channel to be read, and scans that leave the mux half its
+// settling time between the end of one scan and the start of the next, where the driver must skip the
+// thermistors rather than convert an unsettled channel
+#define SIM_THERMISTOR_SWEEP_SCANS  (SIM_THERMISTOR_MUX_CHANNELS + 2)
+#define SIM_THERMISTOR_FAST_SCANS   16
+#define SIM_THERMISTOR_STEP_V       0.3f
+
+// Thermistors of the fault bmb left open, which pulls the divider up to VREF2, and shorted to ground
+#define SIM_THERMISTOR_OPEN         2
+#define SIM_THERMISTOR_SHORT        5
+#define SIM_THERMISTOR_OPEN_V       3.0f
+
+// Power on reset scenario: scans allowed for the driver to resync command counters and deliver good data again
+#define SIM_POR_MAX_SCANS       4
+
+// Chain break scenario: scans allowed for the driver to find a break and deliver good data again
+#define SIM_BREAK_MAX_SCANS     8
+
+// Noise scenario: scans measured at each per packet read error rate
+#define SIM_NOISE_SCANS         200
+
+// Scan rate scenario: scans that must all deliver fresh data, and the resolution of the period search
+#define SIM_RATE_SCANS          16
+#define SIM_RATE_RESOLUTION_US  10
+
+// Mirrors the diagnostic budget and periods in bmb.c, and the task loop period of mainTask
+#define SIM_DIAGNOSTIC_CYCLE_US     50000
+#define SIM_DIAGNOSTIC_BUDGET_US    4200
+#define SIM_TASK_TICK_US            1000
+
+// Scans the diagnostics run alongside before and while they are measured, on the chain of the other scenarios
+// and on a longer one whose flag polls and scans leave little time between them
+#define SIM_DIAGNOSTIC_WARMUP_SCANS     40
+#define SIM_DIAGNOSTIC_SCANS            200
+#define SIM_DIAGNOSTIC_LONG_CHAIN       32
+
+// An overheating die must be flagged within the fault period and the scan that converts it
+#define SIM_DIE_TOLERANCE_C         0.5f
+#define SIM_OVERHEATED_DIE_C        160.0f
+#define SIM_MODULE_TOLERANCE_V      0.01f
+
+// One bmb's sum of cells is off by more than the tolerance in bmb.c and another by less
+#define SIM_SUM_OF_CELLS_FAULT_V    0.5f
+#define SIM_SUM_OF_CELLS_DRIFT_V    0.2f
+#define SIM_SUM_OF_CELLS_DRIFT_BMB  2
+#define SIM_PACK_VOLTAGE_TOLERANCE_V    0.1f
+
+// Pack telemetry is sized by the accumulator configuration, which must cover the longest simulated chain
+#if NUM_BMBS_IN_ACCUMULATOR < SIM_MAX_BMBS
+#error "NUM_BMBS_IN_ACCUMULATOR must be at least SIM_MAX_BMBS"
+#endif
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static PackTelemetry_S pack;
+static PackStats_S packStats;
+
+// Scans run, and those whose published statistics disagree with one pass over the telemetry they came with
+static uint32_t scansChecked = 0;
+static uint32_t statsMismatches = 0;
+
+// Sum of cells reads completed by the task loop, the bus time taken to convert and read them, and the longest
+// time between two of them, counted from when these were last cleared
+static uint32_t moduleVoltageReads = 0;
+static uint64_t moduleVoltageBusUs = 0;
+static uint64_t moduleVoltageMaxGapUs = 0;
+static uint64_t lastModuleVoltageUs = 0;
+
+// Cell voltages at the start of the conversion read back by the current scan
+static float convertedVoltage[SIM_MAX_BMBS][SIM_CELLS_PER_BMB];
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DECLARATIONS ==================== */
+/* ==================================================================== */
+
+static void runScan(uint32_t numBmbs);
+static void runScanWithPeriod(uint32_t numBmbs, uint64_t periodUs);
+static uint32_t countVoltageMismatches(uint32_t numBmbs);
+static bool matchesPackTelemetry(uint32_t numBmbs);
+static uint32_t reportStatsMismatches(void);
+static uint32_t runBulkFallbackScenario(void);
+static uint32_t runPorRecoveryScenario(void);
+static uint32_t runSnapshotCoherenceScenario(void);
+static bool hasCellFlags(uint32_t numBmbs, uint32_t overvoltage, uint32_t undervoltage);
+static bool pollCellFlagsUntil(uint32_t numBmbs, uint32_t overvoltage, uint32_t undervoltage, uint64_t *latencyUs);
+static uint32_t runCellLimitScenario(void);
+static uint32_t countRedundantMismatches(uint32_t numBmbs, uint32_t expected);
+static uint32_t runRedundantAdcScenario(void);
+static uint32_t getExpectedOpenWires(uint32_t bmb, bool open);
+static uint32_t countOpenWireMismatches(uint32_t numBmbs, bool open);
+static void setOpenWires(bool open);
+static uint32_t runOpenWireScenario(void);
+static void runTaskLoop(uint32_t numBmbs, uint32_t numScans, DiagnosticStats_S *stats, uint64_t *measuredUs);
+static uint32_t countDiagnosticMismatches(uint32_t numBmbs, bool overheated);
+static uint32_t reportDiagnostics(uint32_t numBmbs, const DiagnosticStats_S *stats, const uint64_t *measuredUs);
+static uint32_t runDiagnosticScenario(void);
+static uint32_t countSumOfCellsMismatches(uint32_t numBmbs, bool faulted);
+static uint32_t runSumOfCellsScenario(void);
+static void stepThermistorVoltages(uint32_t numBmbs);
+static uint32_t countThermistorMismatches(uint32_t numBmbs, float offset, bool allowOld);
+static uint32_t countThermistorFaultMismatches(uint32_t numBmbs);
+static uint32_t runThermistorScenario(void);
+static void moveCellVoltages(uint32_t numBmbs);
+static void resetDriverChainState(uint32_t numBmbs);
+static uint32_t runChainBreakScenario(uint32_t numBmbs);
+static uint32_t runNoiseScenario(uint32_t numBmbs);
+static void saveConvertedVoltages(uint32_t numBmbs);
+static uint64_t countFreshCells(uint32_t numBmbs);
+static bool isFreshAtPeriod(uint32_t numBmbs, uint64_t periodUs, uint64_t *scanTimeUs);
+static uint32_t runScanRateScenario(uint32_t numBmbs);
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+static void runScan(uint32_t numBmbs)
+{
+    runScanWithPeriod(numBmbs, SIM_SCAN_PERIOD_US);
+}
+
+static void runScanWithPeriod(uint32_t numBmbs, uint64_t periodUs)
+{
+    // Hold the scan until the bmbs finish converting like updatePackTelemetry
+    uint64_t scanStartUs = simGetTimeUs();
+    for(int32_t poll = 0; (poll < SIM_MAX_POLLS) && !isBmbTelemetryReady(numBmbs); poll++)
+    {
+        simAdvanceTimeUs(SIM_POLL_INTERVAL_US);
+    }
+    updateBmbTelemetry(&pack, &packStats, numBmbs);
+    scansChecked++;
+    statsMismatches += matchesPackTelemetry(numBmbs) ? (0) : (1);
+
+    // Read the thermistors in the ticks after the scan like updatePackTelemetry, unless the caller runs the task loop
+    while((periodUs > 0) && isBmbThermistorReadoutDue())
+    {
+        simAdvanceTimeUs((((simGetTimeUs() / SIM_TASK_TICK_US) + 1) * SIM_TASK_TICK_US) - simGetTimeUs());
+        updateBmbThermistors(&pack, numBmbs);
+    }
+
+    // Idle out the remainder of the scan period like updatePackTelemetry
+    uint64_t elapsedUs = simGetTimeUs() - scanStartUs;
+    if(elapsedUs < periodUs)
+    {
+        simAdvanceTimeUs(periodUs - elapsedUs);
+    }
+}
+
+static uint32_t countVoltageMismatches(uint32_t numBmbs)
+{
+    uint32_t mismatches = 0;
+    for(uint32_t i = 0; i < numBmbs; i++)
+    {
+        for(uint32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+        {
+            if(!(pack.cellVoltageValid[i] & (1UL << cell)) ||
+               (fabsf(adcCodeToVolts(pack.cellVoltage[i][cell]) - simGetCellVoltage(i, cell)) > SIM_VOLTAGE_TOLERANCE))
+            {
+                mismatches++;
+            }
+        }
+    }
+    return mismatches;
+}
+
+static bool matchesPackTelemetry(uint32_t numBmbs)
+{
+    // The statistics are gathered as the register groups arrive, so compare them with one pass over the finished scan
+    PackStats_S expected;
+    memset(&expected, 0, sizeof(expected));
+    for(uint32_t i = 0; i < numBmbs; i++)
+    {
+        for(uint32_t cell = 0; cell < NUM_CELLS_PER_BMB; cell++)
+        {
+            if(!(pack.cellVoltageValid[i] & (1UL << cell)))
+            {
+                continue;
+            }
+
+            int16_t code = pack.cellVoltage[i][cell];
+            if((expected.numValidCells == 0) || (code < expected.minCellVoltage))
+            {
+                expected.minCellVoltage = code;
+                expected.minCellBmb = i;
+                expected.minCell = cell;
+            }
+            if((expected.numValidCells == 0) || (code > expected.maxCellVoltage))
+            {
+                expected.maxCellVoltage = code;
+                expected.maxCellBmb = i;
+                expected.maxCell = cell;
+            }
+            expected.sumCellVoltage += code;
+            expected.numValidCells++;
+        }
+    }
+    if(expected.numValidCells > 0)
+    {
+        expected.meanCellVoltage = (int16_t)(expected.sumCellVoltage / (int32_t)expected.numValidCells);
+        expected.cellVoltageSpread = (uint16_t)(expected.maxCellVoltage - expected.minCellVoltage);
+    }
+    return memcmp(&expected, &packStats, sizeof(PackStats_S)) == 0;
+}
+
+static uint32_t reportStatsMismatches(void)
+{
+    printf("\nPack statistics: %lu scans, %lu disagree with the telemetry\n",
+           (unsigned long)scansChecked, (unsigned long)statsMismatches);
+    return statsMismatches;
+}
+
+static uint32_t runBulkFallbackScenario(void)
+{
+    simInit(SIM_FAULT_CHAIN_LENGTH);
+    for(int32_t i = 0; i < SIM_WARMUP_SCANS; i++)
+    {
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+    }
+
+    // Move every cell so stale data from the warmup scans cannot pass the check
+    moveCellVoltages(SIM_FAULT_CHAIN_LENGTH);
+    runScan(SIM_FAULT_CHAIN_LENGTH);
+
+    simCorruptReads(SIM_FAULT_BMB, READ_VOLT_REG_ALL, SIM_FAULT_READS);
+    simResetStats();
+    runScan(SIM_FAULT_CHAIN_LENGTH);
+    SimStats_S stats = simGetStats();
+
+    uint32_t mismatches = countVoltageMismatches(SIM_FAULT_CHAIN_LENGTH);
+    printf("\nBulk read fallback (%d bmbs, bmb %d corrupted): %lu frames, %lu bytes, %lu bad cells\n",
+           SIM_FAULT_CHAIN_LENGTH, SIM_FAULT_BMB,
+           (unsigned long)stats.frames, (unsigned long)stats.bytes, (unsigned long)mismatches);
+    return mismatches;
+}
+
+static uint32_t runPorRecoveryScenario(void)
+{
+    simInit(SIM_FAULT_CHAIN_LENGTH);
+    for(int32_t i = 0; i < SIM_WARMUP_SCANS; i++)
+    {
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+    }
+
+    // A bmb that browns out loses its command counter and results without the driver sending anything
+    simPowerOnReset(SIM_FAULT_BMB);
+    simResetStats();
+    for(int32_t scan = 1; scan <= SIM_POR_MAX_SCANS; scan++)
+    {
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+
+        bool countersSynced = true;
+        for(uint32_t i = 1; i < SIM_FAULT_CHAIN_LENGTH; i++)
+        {
+            countersSynced &= (simGetCommandCounter(i) == simGetCommandCounter(0));
+        }
+        if(countersSynced && (countVoltageMismatches(SIM_FAULT_CHAIN_LENGTH) == 0))
+        {
+            SimStats_S stats = simGetStats();
+            printf("Power on reset recovery (%d bmbs, bmb %d reset): %d scans, %lu frames, %lu bytes\n",
+                   SIM_FAULT_CHAIN_LENGTH, SIM_FAULT_BMB, scan,
+                   (unsigned long)stats.frames, (unsigned long)stats.bytes);
+            return 0;
+        }
+    }
+    printf("Power on reset recovery (%d bmbs, bmb %d reset): not recovered after %d scans\n",
+           SIM_FAULT_CHAIN_LENGTH, SIM_FAULT_BMB, SIM_POR_MAX_SCANS);
+    return 1;
+}
+
+static uint32_t runSnapshotCoherenceScenario(void)
+{
+    simInit(SIM_FAULT_CHAIN_LENGTH);
+    for(int32_t i = 0; i < SIM_WARMUP_SCANS; i++)
+    {
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+    }
+
+    // Lose the release at the end of a scan, so that bmb stays frozen while the others convert moved cells.
+    // Move the cells again as the next scan starts, so it sees three generations of cell voltages
+    static float generation[SIM_COHERENCE_GENERATIONS][SIM_FAULT_CHAIN_LENGTH][SIM_CELLS_PER_BMB];
+    simDropCommands(SIM_FAULT_BMB, CMD_RELEASE_SNAPSHOT, 1);
+    runScan(SIM_FAULT_CHAIN_LENGTH);
+    for(int32_t g = 0; g < SIM_COHERENCE_GENERATIONS; g++)
+    {
+        if(g > 0)
+        {
+            moveCellVoltages(SIM_FAULT_CHAIN_LENGTH);
+            simAdvanceTimeUs((g < (SIM_COHERENCE_GENERATIONS - 1)) ? (2 * SIM_CONVERSION_TIME_US) : (0));
+        }
+        for(uint32_t i = 0; i < SIM_FAULT_CHAIN_LENGTH; i++)
+        {
+            for(uint32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+            {
+                generation[g][i][cell] = simGetCellVoltage(i, cell);
+            }
+        }
+    }
+    simResetStats();
+    runScan(SIM_FAULT_CHAIN_LENGTH);
+    SimStats_S stats = simGetStats();
+
+    // Any generation may be read back, but every bmb must have read the same one as the first bmb
+    int32_t readGeneration = 0;
+    for(int32_t g = 0; g < SIM_COHERENCE_GENERATIONS; g++)
+    {
+        if(fabsf(adcCodeToVolts(pack.cellVoltage[0][0]) - generation[g][0][0]) <= SIM_VOLTAGE_TOLERANCE)
+        {
+            readGeneration = g;
+        }
+    }
+    uint32_t mixedCells = 0;
+    for(uint32_t i = 0; i < SIM_FAULT_CHAIN_LENGTH; i++)
+    {
+        for(uint32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+        {
+            if(!(pack.cellVoltageValid[i] & (1UL << cell)) ||
+               (fabsf(adcCodeToVolts(pack.cellVoltage[i][cell]) - generation[readGeneration][i][cell]) > SIM_VOLTAGE_TOLERANCE))
+            {
+                mixedCells++;
+            }
+        }
+    }
+
+    printf("Missed snapshot release (%d bmbs, bmb %d): %lu frames, %lu bytes, %lu cells from another conversion\n",
+           SIM_FAULT_CHAIN_LENGTH, SIM_FAULT_BMB,
+           (unsigned long)stats.frames, (unsigned long)stats.bytes, (unsigned long)mixedCells);
+    return mixedCells;
+}
+
+static bool hasCellFlags(uint32_t numBmbs, uint32_t overvoltage, uint32_t undervoltage)
+{
+    // Only the fault bmb may be flagged, and only on the expected cells
+    for(uint32_t i = 0; i < numBmbs; i++)
+    {
+        bool faultBmb = (i == SIM_FAULT_BMB);
+        if((pack.cellVoltageFlagsValid[i] != ((1UL << SIM_CELLS_PER_BMB) - 1)) ||
+           (pack.cellOvervoltageFlags[i] != ((faultBmb) ? (overvoltage) : (0))) ||
+           (pack.cellUndervoltageFlags[i] != ((faultBmb) ? (undervoltage) : (0))))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool pollCellFlagsUntil(uint32_t numBmbs, uint32_t overvoltage, uint32_t undervoltage, uint64_t *latencyUs)
+{
+    // Poll the flags between scans like updatePackTelemetry until they read as expected
+    uint64_t startUs = simGetTimeUs();
+    uint64_t lastScanUs = startUs;
+    while((simGetTimeUs() - startUs) < (SIM_LIMIT_MAX_SCANS * SIM_SCAN_PERIOD_US))
+    {
+        simAdvanceTimeUs(SIM_FLAG_POLL_PERIOD_US);
+        if((simGetTimeUs() - lastScanUs) >= SIM_SCAN_PERIOD_US)
+        {
+            lastScanUs = simGetTimeUs();
+            runScanWithPeriod(numBmbs, 0);
+            continue;
+        }
+
+        updateCellVoltageFlags(&pack, numBmbs);
+        if(hasCellFlags(numBmbs, overvoltage, undervoltage))
+        {
+            *latencyUs = simGetTimeUs() - startUs;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t runCellLimitScenario(void)
+{
+    simInit(SIM_FAULT_CHAIN_LENGTH);
+    setCellVoltageLimits(SIM_UNDERVOLTAGE_LIMIT_V, SIM_OVERVOLTAGE_LIMIT_V);
+    for(int32_t i = 0; i < SIM_WARMUP_SCANS; i++)
+    {
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+    }
+
+    // Bus cost of a flag poll against a full scan, with every cell inside its limits. The first poll writes the limits
+    uint32_t failures = 0;
+    updateCellVoltageFlags(&pack, SIM_FAULT_CHAIN_LENGTH);
+    simResetStats();
+    updateCellVoltageFlags(&pack, SIM_FAULT_CHAIN_LENGTH);
+    SimStats_S pollStats = simGetStats();
+    failures += hasCellFlags(SIM_FAULT_CHAIN_LENGTH, 0, 0) ? (0) : (1);
+    simResetStats();
+    runScanWithPeriod(SIM_FAULT_CHAIN_LENGTH, 0);
+    SimStats_S scanStats = simGetStats();
+
+    // Both limits trip, then clear once the cells recover
+    const uint32_t overvoltage = 1UL << SIM_OVERVOLTAGE_CELL;
+    const uint32_t undervoltage = 1UL << SIM_UNDERVOLTAGE_CELL;
+    float overvoltageCell = simGetCellVoltage(SIM_FAULT_BMB, SIM_OVERVOLTAGE_CELL);
+    float undervoltageCell = simGetCellVoltage(SIM_FAULT_BMB, SIM_UNDERVOLTAGE_CELL);
+    simSetCellVoltage(SIM_FAULT_BMB, SIM_OVERVOLTAGE_CELL, SIM_OVERVOLTAGE_LIMIT_V + 0.1f);
+    simSetCellVoltage(SIM_FAULT_BMB, SIM_UNDERVOLTAGE_CELL, SIM_UNDERVOLTAGE_LIMIT_V - 0.1f);
+    uint64_t tripUs = 0;
+    failures += pollCellFlagsUntil(SIM_FAULT_CHAIN_LENGTH, overvoltage, undervoltage, &tripUs) ? (0) : (1);
+
+    simSetCellVoltage(SIM_FAULT_BMB, SIM_OVERVOLTAGE_CELL, overvoltageCell);
+    simSetCellVoltage(SIM_FAULT_BMB, SIM_UNDERVOLTAGE_CELL, undervoltageCell);
+    uint64_t clearUs = 0;
+    failures += pollCellFlagsUntil(SIM_FAULT_CHAIN_LENGTH, 0, 0, &clearUs) ? (0) : (1);
+
+    // A reset bmb comes back with the default limits, so the driver must write them again
+    simPowerOnReset(SIM_FAULT_BMB);
+    for(int32_t i = 0; i < SIM_WARMUP_SCANS; i++)
+    {
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+    }
+    simSetCellVoltage(SIM_FAULT_BMB, SIM_OVERVOLTAGE_CELL, SIM_OVERVOLTAGE_LIMIT_V + 0.1f);
+    uint64_t resetTripUs = 0;
+    failures += pollCellFlagsUntil(SIM_FAULT_CHAIN_LENGTH, overvoltage, 0, &resetTripUs) ? (0) : (1);
+
+    printf("Cell limit flags (%d bmbs): poll %lu bytes %llu us, scan %lu bytes %llu us, "
+           "tripped after %llu us, cleared after %llu us, tripped after reset %llu us, %lu failures\n",
+           SIM_FAULT_CHAIN_LENGTH, (unsigned long)pollStats.bytes, (unsigned long long)pollStats.busTimeUs,
+           (unsigned long)scanStats.bytes, (unsigned long long)scanStats.busTimeUs,
+           (unsigned long long)tripUs, (unsigned long long)clearUs, (unsigned long long)resetTripUs, (unsigned long)failures);
+    return failures;
+}
+
+static uint32_t countRedundantMismatches(uint32_t numBmbs, uint32_t expected)
+{
+    // Every cell must have both results, and only the expected cells of the fault bmb may disagree
+    uint32_t wrong = 0;
+    for(uint32_t i = 0; i < numBmbs; i++)
+    {
+        uint32_t compared = pack.cAdcVoltageValid[i] & pack.sAdcVoltageValid[i];
+        uint32_t mismatch = pack.redundantAdcMismatch[i] & compared;
+        wrong += __builtin_popcount(((1UL << SIM_CELLS_PER_BMB) - 1) & ~compared);
+        wrong += __builtin_popcount(mismatch ^ ((i == SIM_FAULT_BMB) ? (expected) : (0)));
+    }
+    return wrong;
+}
+
+static uint32_t runRedundantAdcScenario(void)
+{
+    simInit(SIM_FAULT_CHAIN_LENGTH);
+    for(int32_t i = 0; i < SIM_WARMUP_SCANS + SIM_REDUNDANT_DETECTION_SCANS; i++)
+    {
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+    }
+    uint32_t healthy = countRedundantMismatches(SIM_FAULT_CHAIN_LENGTH, 0);
+
+    // Results reflect the conversion started before the error appeared, so give it a scan to come through
+    simSetRedundantAdcError(SIM_FAULT_BMB, SIM_REDUNDANT_CELL, SIM_REDUNDANT_FAULT_V);
+    simSetRedundantAdcError(SIM_FAULT_BMB, SIM_REDUNDANT_CELL + 1, -SIM_REDUNDANT_DRIFT_V);
+    runScan(SIM_FAULT_CHAIN_LENGTH);
+
+    // The fault must be flagged within one rotation, after any open wire check holding the S-ADC, and the
+    // cell drifting inside the tolerance never is
+    SimStats_S stats = { 0 };
+    uint32_t detectionScans = 0;
+    for(uint32_t scan = 1; scan <= SIM_REDUNDANT_DETECTION_SCANS; scan++)
+    {
+        simResetStats();
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+        stats = (scan == 1) ? (simGetStats()) : (stats);
+        if((detectionScans == 0) && (pack.redundantAdcMismatch[SIM_FAULT_BMB] & (1UL << SIM_REDUNDANT_CELL)))
+        {
+            detectionScans = scan;
+        }
+    }
+    uint32_t faulted = countRedundantMismatches(SIM_FAULT_CHAIN_LENGTH, 1UL << SIM_REDUNDANT_CELL);
+
+    simSetRedundantAdcError(SIM_FAULT_BMB, SIM_REDUNDANT_CELL, 0.0f);
+    simSetRedundantAdcError(SIM_FAULT_BMB, SIM_REDUNDANT_CELL + 1, 0.0f);
+    for(int32_t i = 0; i <= SIM_REDUNDANT_DETECTION_SCANS; i++)
+    {
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+    }
+    uint32_t recovered = countRedundantMismatches(SIM_FAULT_CHAIN_LENGTH, 0);
+
+    printf("Redundant ADC check (%d bmbs, bmb %d cell %d off by %.0f mV): scan %lu frames, %lu bytes, %llu us, "
+           "flagged after %lu scans, %lu wrong before, %lu during, %lu after\n",
+           SIM_FAULT_CHAIN_LENGTH, SIM_FAULT_BMB, SIM_REDUNDANT_CELL, (double)(SIM_REDUNDANT_FAULT_V * 1000.0f),
+           (unsigned long)stats.frames, (unsigned long)stats.bytes, (unsigned long long)stats.busTimeUs,
+           (unsigned long)detectionScans, (unsigned long)healthy, (unsigned long)faulted, (unsigned long)recovered);
+    return healthy + faulted + recovered + ((detectionScans == 0) ? (1) : (0));
+}
+
+static uint32_t getExpectedOpenWires(uint32_t bmb, bool open)
+{
+    // An open tap shows on both cells it bounds, and the top and bottom taps bound a single cell
+    if(!open)
+    {
+        return 0;
+    }
+    uint32_t expected = (bmb == SIM_FAULT_BMB) ? ((1UL << (SIM_OPEN_WIRE_TAP - 1)) | (1UL << SIM_OPEN_WIRE_TAP)) : (0);
+    expected |= (bmb == SIM_OPEN_WIRE_TOP_BMB) ? (1UL << (SIM_CELLS_PER_BMB - 1)) : (0);
+    expected |= (bmb == SIM_OPEN_WIRE_BOTTOM_BMB) ? (1UL << 0) : (0);
+    return expected;
+}
+
+static uint32_t countOpenWireMismatches(uint32_t numBmbs, bool open)
+{
+    // Every cell must have been checked, and only the cells bounding an open tap may be flagged
+    uint32_t wrong = 0;
+    for(uint32_t i = 0; i < numBmbs; i++)
+    {
+        wrong += __builtin_popcount(((1UL << SIM_CELLS_PER_BMB) - 1) & ~pack.cellOpenWireValid[i]);
+        wrong += __builtin_popcount((pack.cellOpenWire[i] & pack.cellOpenWireValid[i]) ^ getExpectedOpenWires(i, open));
+    }
+    return wrong;
+}
+
+static void setOpenWires(bool open)
+{
+    simSetOpenWire(SIM_FAULT_BMB, SIM_OPEN_WIRE_TAP, open);
+    simSetOpenWire(SIM_OPEN_WIRE_TOP_BMB, SIM_CELLS_PER_BMB, open);
+    simSetOpenWire(SIM_OPEN_WIRE_BOTTOM_BMB, 0, open);
+}
+
+static uint32_t runOpenWireScenario(void)
+{
+    simInit(SIM_FAULT_CHAIN_LENGTH);
+    for(int32_t i = 0; i < SIM_WARMUP_SCANS + SIM_OPEN_WIRE_PERIOD_SCANS; i++)
+    {
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+    }
+    uint32_t healthy = countOpenWireMismatches(SIM_FAULT_CHAIN_LENGTH, false);
+
+    // Every open tap must be flagged once a whole check has run after it opened, wherever the check had got to
+    setOpenWires(true);
+    simResetStats();
+    uint64_t startUs = simGetTimeUs();
+    uint32_t detectionScans = 0;
+    uint32_t badCells = 0;
+    for(uint32_t scan = 1; scan <= (2 * SIM_OPEN_WIRE_PERIOD_SCANS); scan++)
+    {
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+        badCells += countVoltageMismatches(SIM_FAULT_CHAIN_LENGTH);
+        if((detectionScans == 0) && (countOpenWireMismatches(SIM_FAULT_CHAIN_LENGTH, true) == 0))
+        {
+            detectionScans = scan;
+        }
+    }
+    uint32_t faulted = countOpenWireMismatches(SIM_FAULT_CHAIN_LENGTH, true);
+
+    // The share of the bus is measured over every scan, idle time included, as the budget is
+    SimStats_S stats = simGetStats();
+    double busPercent = (100.0 * stats.openWireBusTimeUs) / (double)(simGetTimeUs() - startUs);
+
+    // Repaired taps clear, and the redundant check has carried on between checks
+    setOpenWires(false);
+    for(int32_t i = 0; i < (2 * SIM_OPEN_WIRE_PERIOD_SCANS); i++)
+    {
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+    }
+    uint32_t repaired = countOpenWireMismatches(SIM_FAULT_CHAIN_LENGTH, false);
+    uint32_t redundant = countRedundantMismatches(SIM_FAULT_CHAIN_LENGTH, 0);
+
+    printf("Open wire check (%d bmbs, taps open on bmbs %d, %d and %d): %.2f %% of the bus (%llu us over %lu scans), "
+           "flagged after %lu scans, %lu wrong before, %lu during, %lu after, %lu bad cells, %lu redundant wrong\n",
+           SIM_FAULT_CHAIN_LENGTH, SIM_FAULT_BMB, SIM_OPEN_WIRE_TOP_BMB, SIM_OPEN_WIRE_BOTTOM_BMB, busPercent,
+           (unsigned long long)stats.openWireBusTimeUs, (unsigned long)(2 * SIM_OPEN_WIRE_PERIOD_SCANS),
+           (unsigned long)detectionScans, (unsigned long)healthy, (unsigned long)faulted, (unsigned long)repaired,
+           (unsigned long)badCells, (unsigned long)redundant);
+    return healthy + faulted + repaired + badCells + redundant + ((detectionScans == 0) ? (1) : (0)) +
+           ((busPercent > (SIM_OPEN_WIRE_BUS_PERCENT + SIM_OPEN_WIRE_SLACK_PERCENT)) ? (1) : (0));
+}
+
+static void runTaskLoop(uint32_t numBmbs, uint32_t numScans, DiagnosticStats_S *stats, uint64_t *measuredUs)
+{
+    // One pass per tick like updatePackTelemetry: a scan when due, otherwise the diagnostics on the pass after a
+    // scan, otherwise a flag poll when due, otherwise the sum of cells when due, otherwise the thermistor readout
+    // when due, otherwise the diagnostics. The bus time each diagnostic actually took is added up alongside the
+    // driver's estimate
+    uint64_t endUs = simGetTimeUs() + (numScans * SIM_SCAN_PERIOD_US);
+    uint64_t lastScanUs = simGetTimeUs() - SIM_SCAN_PERIOD_US;
+    uint64_t lastFlagUs = lastScanUs;
+    bool diagnosticSlot = false;
+    while(simGetTimeUs() < endUs)
+    {
+        uint64_t tickUs = simGetTimeUs();
+        bool runDiagnostics = false;
+        if((tickUs - lastScanUs) >= SIM_SCAN_PERIOD_US)
+        {
+            lastScanUs = tickUs;
+            runScanWithPeriod(numBmbs, 0);
+            diagnosticSlot = true;
+        }
+        else if(diagnosticSlot)
+        {
+            diagnosticSlot = false;
+            runDiagnostics = true;
+        }
+        else if((tickUs - lastFlagUs) >= SIM_FLAG_POLL_PERIOD_US)
+        {
+            lastFlagUs = tickUs;
+            updateCellVoltageFlags(&pack, numBmbs);
+        }
+        else if(isBmbModuleVoltageDue())
+        {
+            // The sum of cells stays due from the start of its conversion until it has been read
+            uint64_t busTimeUs = simGetStats().busTimeUs;
+            updateBmbModuleVoltages(&pack, numBmbs);
+            moduleVoltageBusUs += simGetStats().busTimeUs - busTimeUs;
+            if(!isBmbModuleVoltageDue())
+            {
+                moduleVoltageMaxGapUs = ((tickUs - lastModuleVoltageUs) > moduleVoltageMaxGapUs) ? (tickUs - lastModuleVoltageUs) : (moduleVoltageMaxGapUs);
+                lastModuleVoltageUs = tickUs;
+                moduleVoltageReads++;
+            }
+        }
+        else if(isBmbThermistorReadoutDue())
+        {
+            updateBmbThermistors(&pack, numBmbs);
+        }
+        else
+        {
+            runDiagnostics = true;
+        }
+
+        if(runDiagnostics)
+        {
+            DiagnosticStats_S before = *stats;
+            uint64_t busTimeUs = simGetStats().busTimeUs;
+            updateBmbDiagnostics(&pack, stats, numBmbs);
+            for(uint32_t d = 0; d < NUM_DIAGNOSTICS; d++)
+            {
+                measuredUs[d] += (stats->runs[d] != before.runs[d]) ? (simGetStats().busTimeUs - busTimeUs) : (0);
+            }
+        }
+        simAdvanceTimeUs((((simGetTimeUs() / SIM_TASK_TICK_US) + 1) * SIM_TASK_TICK_US) - simGetTimeUs());
+    }
+}
+
+static uint32_t countDiagnosticMismatches(uint32_t numBmbs, bool overheated)
+{
+    // Every bmb must report its die temperature and the sum of its cells, and only a die that overheated a fault
+    uint32_t wrong = 0;
+    for(uint32_t i = 0; i < numBmbs; i++)
+    {
+        float sum = 0.0f;
+        for(uint32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+        {
+            sum += simGetCellVoltage(i, cell);
+        }
+        float dieTemperature = SIM_DEFAULT_DIE_TEMPERATURE_C + (float)(i % 16);
+        uint32_t faults = (overheated && (i == SIM_FAULT_BMB)) ? (BMB_FAULT_THSD) : (0);
+        wrong += (pack.statusResultValid[i] & (1UL << STATUS_RESULT_ITMP)) ? (0) : (1);
+        wrong += (fabsf(adcCodeToDieTemperature(pack.statusResult[i][STATUS_RESULT_ITMP]) - dieTemperature) <= SIM_DIE_TOLERANCE_C) ? (0) : (1);
+        wrong += (pack.moduleVoltageValid[i] & (1UL << MODULE_VOLTAGE_VPV)) ? (0) : (1);
+        wrong += (fabsf(adcCodeToModuleVolts(pack.moduleVoltage[i][MODULE_VOLTAGE_VPV]) - sum) <= SIM_MODULE_TOLERANCE_V) ? (0) : (1);
+        wrong += (pack.bmbFaultFlagsValid[i] != 0) ? (0) : (1);
+        wrong += (pack.bmbFaultFlags[i] == faults) ? (0) : (1);
+    }
+    return wrong;
+}
+
+static uint32_t reportDiagnostics(uint32_t numBmbs, const DiagnosticStats_S *stats, const uint64_t *measuredUs)
+{
+    static const char *names[NUM_DIAGNOSTICS] = { "References", "Supplies", "Faults" };
+    static const uint32_t periodsMs[NUM_DIAGNOSTICS] = { 1000, 1000, 250 };
+
+    printf("\nDiagnostics (%lu bmbs, %d us per %d ms cycle)\n", (unsigned long)numBmbs, SIM_DIAGNOSTIC_BUDGET_US,
+           SIM_DIAGNOSTIC_CYCLE_US / 1000);
+    printf("| Diagnostic      | Period (ms) | Runs | Forced | Longest gap (ms) | Estimated (us) | Measured (us) |\n");
+    printf("|-----------------|-------------|------|--------|------------------|----------------|---------------|\n");
+    uint32_t failures = 0;
+    uint64_t totalUs = 0;
+    for(uint32_t d = 0; d < NUM_DIAGNOSTICS; d++)
+    {
+        printf("| %-15s | %11lu | %4lu | %6lu | %16lu | %14llu | %13llu |\n", names[d], (unsigned long)periodsMs[d],
+               (unsigned long)stats->runs[d], (unsigned long)stats->forcedRuns[d], (unsigned long)stats->maxIntervalMs[d],
+               (unsigned long long)stats->busTimeUs[d], (unsigned long long)measuredUs[d]);
+        totalUs += measuredUs[d];
+
+        // Every diagnostic keeps its period, and the estimate the budget is kept with matches the bus
+        failures += (stats->maxIntervalMs[d] <= periodsMs[d]) ? (0) : (1);
+        failures += (stats->runs[d] > 0) ? (0) : (1);
+        failures += (stats->busTimeUs[d] == measuredUs[d]) ? (0) : (1);
+        failures += (stats->forcedRuns[d] == 0) ? (0) : (1);
+    }
+
+    // Within the budget, the diagnostics never take more than its share of the bus
+    double busPercent = (100.0 * totalUs) / ((double)SIM_DIAGNOSTIC_SCANS * SIM_SCAN_PERIOD_US);
+    double budgetPercent = (100.0 * SIM_DIAGNOSTIC_BUDGET_US) / SIM_DIAGNOSTIC_CYCLE_US;
+    printf("Diagnostics used %.2f %% of the bus against a budget of %.2f %%\n", busPercent, budgetPercent);
+    failures += (busPercent <= budgetPercent) ? (0) : (1);
+    return failures;
+}
+
+static uint32_t runDiagnosticScenario(void)
+{
+    DiagnosticStats_S stats;
+    uint64_t measuredUs[NUM_DIAGNOSTICS];
+
+    simInit(SIM_FAULT_CHAIN_LENGTH);
+    memset(&stats, 0, sizeof(stats));
+    memset(measuredUs, 0, sizeof(measuredUs));
+    runTaskLoop(SIM_FAULT_CHAIN_LENGTH, SIM_DIAGNOSTIC_WARMUP_SCANS, &stats, measuredUs);
+    memset(&stats, 0, sizeof(stats));
+    memset(measuredUs, 0, sizeof(measuredUs));
+    runTaskLoop(SIM_FAULT_CHAIN_LENGTH, SIM_DIAGNOSTIC_SCANS, &stats, measuredUs);
+    uint32_t failures = reportDiagnostics(SIM_FAULT_CHAIN_LENGTH, &stats, measuredUs);
+    uint32_t healthy = countDiagnosticMismatches(SIM_FAULT_CHAIN_LENGTH, false);
+
+    // An overheated die latches thermal shutdown at its next aux conversion, which the fault read then finds.
+    // The fault stays latched once the die cools
+    simSetDieTemperature(SIM_FAULT_BMB, SIM_OVERHEATED_DIE_C);
+    uint32_t detectionScans = 0;
+    for(uint32_t scan = 1; (scan <= SIM_DIAGNOSTIC_WARMUP_SCANS) && (detectionScans == 0); scan++)
+    {
+        runTaskLoop(SIM_FAULT_CHAIN_LENGTH, 1, &stats, measuredUs);
+        detectionScans = (pack.bmbFaultFlags[SIM_FAULT_BMB] & BMB_FAULT_THSD) ? (scan) : (0);
+    }
+    simSetDieTemperature(SIM_FAULT_BMB, SIM_DEFAULT_DIE_TEMPERATURE_C + SIM_FAULT_BMB);
+    runTaskLoop(SIM_FAULT_CHAIN_LENGTH, SIM_DIAGNOSTIC_WARMUP_SCANS, &stats, measuredUs);
+    uint32_t faulted = countDiagnosticMismatches(SIM_FAULT_CHAIN_LENGTH, true);
+
+    // A longer chain still keeps every period within the budget
+    simInit(SIM_DIAGNOSTIC_LONG_CHAIN);
+    runTaskLoop(SIM_DIAGNOSTIC_LONG_CHAIN, SIM_DIAGNOSTIC_WARMUP_SCANS, &stats, measuredUs);
+    memset(&stats, 0, sizeof(stats));
+    memset(measuredUs, 0, sizeof(measuredUs));
+    runTaskLoop(SIM_DIAGNOSTIC_LONG_CHAIN, SIM_DIAGNOSTIC_SCANS, &stats, measuredUs);
+    failures += reportDiagnostics(SIM_DIAGNOSTIC_LONG_CHAIN, &stats, measuredUs);
+
+    printf("Diagnostic results (%d bmbs): thermal shutdown on bmb %d flagged after %lu scans, %lu wrong before, %lu after\n",
+           SIM_FAULT_CHAIN_LENGTH, SIM_FAULT_BMB, (unsigned long)detectionScans, (unsigned long)healthy, (unsigned long)faulted);
+    return failures + healthy + faulted + ((detectionScans == 0) ? (1) : (0));
+}
+
+static uint32_t countSumOfCellsMismatches(uint32_t numBmbs, bool faulted)
+{
+    // Every bmb must be checked and only the faulted one flagged, and the coarse pack voltage covers every bmb
+    uint32_t wrong = 0;
+    float packVoltage = 0.0f;
+    for(uint32_t i = 0; i < numBmbs; i++)
+    {
+        for(uint32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+        {
+            packVoltage += simGetCellVoltage(i, cell);
+        }
+        wrong += (pack.sumOfCellsChecked[i]) ? (0) : (1);
+        wrong += (pack.sumOfCellsMismatch[i] == (faulted && (i == SIM_FAULT_BMB))) ? (0) : (1);
+    }
+    packVoltage += (faulted) ? (SIM_SUM_OF_CELLS_FAULT_V + SIM_SUM_OF_CELLS_DRIFT_V) : (0.0f);
+    wrong += (pack.numModulePackVoltages == numBmbs) ? (0) : (1);
+    wrong += (fabsf(adcCodeSumToModuleVolts(pack.modulePackVoltage, pack.numModulePackVoltages) - packVoltage) <=
+              SIM_PACK_VOLTAGE_TOLERANCE_V) ? (0) : (1);
+    return wrong;
+}
+
+static uint32_t runSumOfCellsScenario(void)
+{
+    DiagnosticStats_S stats;
+    uint64_t measuredUs[NUM_DIAGNOSTICS];
+    memset(&stats, 0, sizeof(stats));
+    memset(measuredUs, 0, sizeof(measuredUs));
+
+    simInit(SIM_FAULT_CHAIN_LENGTH);
+    runTaskLoop(SIM_FAULT_CHAIN_LENGTH, SIM_DIAGNOSTIC_WARMUP_SCANS, &stats, measuredUs);
+    uint32_t healthy = countSumOfCellsMismatches(SIM_FAULT_CHAIN_LENGTH, false);
+
+    // The coarse pack voltage costs a V+ conversion and a single register group read against a full scan. Read on
+    // its own period, it must refresh faster than the scans even when it slips behind a scan and a flag poll
+    simResetStats();
+    runScanWithPeriod(SIM_FAULT_CHAIN_LENGTH, 0);
+    uint64_t scanUs = simGetStats().busTimeUs;
+    moduleVoltageReads = 0;
+    moduleVoltageBusUs = 0;
+    moduleVoltageMaxGapUs = 0;
+    lastModuleVoltageUs = simGetTimeUs();
+    uint64_t startUs = simGetTimeUs();
+    runTaskLoop(SIM_FAULT_CHAIN_LENGTH, SIM_DIAGNOSTIC_WARMUP_SCANS, &stats, measuredUs);
+    uint64_t readUs = (moduleVoltageReads > 0) ? (moduleVoltageBusUs / moduleVoltageReads) : (0);
+    uint64_t longestGapUs = moduleVoltageMaxGapUs;
+    double busPercent = (100.0 * moduleVoltageBusUs) / (double)(simGetTimeUs() - startUs);
+
+    // A bmb whose sum of cells disagrees beyond the tolerance is flagged once the module voltages are next read,
+    // and one inside the tolerance never is
+    simSetSumOfCellsError(SIM_FAULT_BMB, SIM_SUM_OF_CELLS_FAULT_V);
+    simSetSumOfCellsError(SIM_SUM_OF_CELLS_DRIFT_BMB, SIM_SUM_OF_CELLS_DRIFT_V);
+    uint32_t detectionScans = 0;
+    for(uint32_t scan = 1; (scan <= SIM_DIAGNOSTIC_WARMUP_SCANS) && (detectionScans == 0); scan++)
+    {
+        runTaskLoop(SIM_FAULT_CHAIN_LENGTH, 1, &stats, measuredUs);
+        detectionScans = (pack.sumOfCellsMismatch[SIM_FAULT_BMB]) ? (scan) : (0);
+    }
+    runTaskLoop(SIM_FAULT_CHAIN_LENGTH, SIM_DIAGNOSTIC_WARMUP_SCANS / 2, &stats, measuredUs);
+    uint32_t faulted = countSumOfCellsMismatches(SIM_FAULT_CHAIN_LENGTH, true);
+
+    simSetSumOfCellsError(SIM_FAULT_BMB, 0.0f);
+    simSetSumOfCellsError(SIM_SUM_OF_CELLS_DRIFT_BMB, 0.0f);
+    runTaskLoop(SIM_FAULT_CHAIN_LENGTH, SIM_DIAGNOSTIC_WARMUP_SCANS / 2, &stats, measuredUs);
+    uint32_t recovered = countSumOfCellsMismatches(SIM_FAULT_CHAIN_LENGTH, false);
+
+    printf("Sum of cells check (%d bmbs, bmb %d off by %.1f V): %llu us per read against a %llu us scan, %.2f %% of the bus, "
+           "longest gap %llu ms, flagged after %lu scans, %lu wrong before, %lu during, %lu after\n",
+           SIM_FAULT_CHAIN_LENGTH, SIM_FAULT_BMB, (double)SIM_SUM_OF_CELLS_FAULT_V, (unsigned long long)readUs,
+           (unsigned long long)scanUs, busPercent, (unsigned long long)(longestGapUs / 1000), (unsigned long)detectionScans,
+           (unsigned long)healthy, (unsigned long)faulted, (unsigned long)recovered);
+    return healthy + faulted + recovered + ((detectionScans == 0) ? (1) : (0)) +
+           ((longestGapUs >= SIM_SCAN_PERIOD_US) ? (1) : (0));
+}
+
+static void stepThermistorVoltages(uint32_t numBmbs)
+{
+    for(uint32_t i = 0; i < numBmbs; i++)
+    {
+        for(uint32_t t = 0; t < SIM_THERMISTORS_PER_BMB; t++)
+        {
+            simSetThermistorVoltage(i, t, simGetThermistorVoltage(i, t) + SIM_THERMISTOR_STEP_V);
+        }
+    }
+}
+
+static uint32_t countThermistorMismatches(uint32_t numBmbs, float offset, bool allowOld)
+{
+    // Each thermistor must read its own voltage, or its voltage before the offset was applied if allowed
+    uint32_t wrong = 0;
+    for(uint32_t i = 0; i < numBmbs; i++)
+    {
+        for(uint32_t t = 0; t < SIM_THERMISTORS_PER_BMB; t++)
+        {
+            float measured = adcCodeToVolts(pack.thermistorVoltage[i][t]);
+            float voltage = simGetThermistorVoltage(i, t);
+            bool current = fabsf(measured - voltage) <= SIM_VOLTAGE_TOLERANCE;
+            bool old = allowOld && (fabsf(measured - (voltage - offset)) <= SIM_VOLTAGE_TOLERANCE);
+            wrong += ((pack.thermistorVoltageValid[i] & (1UL << t)) && (current || old)) ? (0) : (1);
+        }
+    }
+    return wrong;
+}
+
+static uint32_t countThermistorFaultMismatches(uint32_t numBmbs)
+{
+    // Only the open and shorted thermistors may be flagged, and every other thermistor must have a temperature
+    uint32_t wrong = 0;
+    for(uint32_t i = 0; i < numBmbs; i++)
+    {
+        uint32_t open = (i == SIM_FAULT_BMB) ? (1UL << SIM_THERMISTOR_OPEN) : (0);
+        uint32_t shorted = (i == SIM_FAULT_BMB) ? (1UL << SIM_THERMISTOR_SHORT) : (0);
+        uint32_t good = ((1UL << SIM_THERMISTORS_PER_BMB) - 1) & ~open & ~shorted;
+        wrong += (pack.thermistorOpen[i] == open) ? (0) : (1);
+        wrong += (pack.thermistorShort[i] == shorted) ? (0) : (1);
+        wrong += (pack.thermistorTemperatureValid[i] == good) ? (0) : (1);
+    }
+    return wrong;
+}
+
+static uint32_t runThermistorScenario(void)
+{
+    simInit(SIM_FAULT_CHAIN_LENGTH);
+    for(int32_t i = 0; i < SIM_WARMUP_SCANS + SIM_THERMISTOR_SWEEP_SCANS; i++)
+    {
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+    }
+    uint32_t initial = countThermistorMismatches(SIM_FAULT_CHAIN_LENGTH, 0.0f, false);
+
+    simResetStats();
+    runScan(SIM_FAULT_CHAIN_LENGTH);
+    uint64_t fastPeriodUs = simGetStats().busTimeUs + (SIM_MUX_SETTLING_US / 2);
+
+    // Scans closer together than the mux settles may only ever report a thermistor's old or new voltage
+    stepThermistorVoltages(SIM_FAULT_CHAIN_LENGTH);
+    uint32_t unsettled = 0;
+    for(int32_t i = 0; i < SIM_THERMISTOR_FAST_SCANS; i++)
+    {
+        runScanWithPeriod(SIM_FAULT_CHAIN_LENGTH, fastPeriodUs);
+        unsettled += countThermistorMismatches(SIM_FAULT_CHAIN_LENGTH, SIM_THERMISTOR_STEP_V, true);
+    }
+
+    // At the normal scan period every thermistor catches up within a sweep of the mux channels
+    runScan(SIM_FAULT_CHAIN_LENGTH);
+    stepThermistorVoltages(SIM_FAULT_CHAIN_LENGTH);
+    simResetStats();
+    uint32_t sweepScans = 0;
+    for(uint32_t scan = 1; (scan <= SIM_THERMISTOR_SWEEP_SCANS) && (sweepScans == 0); scan++)
+    {
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+        sweepScans = (countThermistorMismatches(SIM_FAULT_CHAIN_LENGTH, 0.0f, false) == 0) ? (scan) : (0);
+    }
+    SimStats_S stats = simGetStats();
+    uint32_t updated = countThermistorMismatches(SIM_FAULT_CHAIN_LENGTH, 0.0f, false);
+
+    // An open and a shorted thermistor are flagged once their channel comes round
+    simSetThermistorVoltage(SIM_FAULT_BMB, SIM_THERMISTOR_OPEN, SIM_THERMISTOR_OPEN_V);
+    simSetThermistorVoltage(SIM_FAULT_BMB, SIM_THERMISTOR_SHORT, 0.0f);
+    for(int32_t i = 0; i < SIM_THERMISTOR_SWEEP_SCANS; i++)
+    {
+        runScan(SIM_FAULT_CHAIN_LENGTH);
+    }
+    uint32_t faults = countThermistorFaultMismatches(SIM_FAULT_CHAIN_LENGTH);
+
+    printf("Thermistor scan (%d bmbs, %d thermistors each): %lu bytes %llu us per scan, all updated after %lu scans, "
+           "%lu wrong at start, %lu while unsettled, %lu after, %lu open or short flags wrong\n",
+           SIM_FAULT_CHAIN_LENGTH, SIM_THERMISTORS_PER_BMB, (unsigned long)(stats.bytes / ((sweepScans > 0) ? (sweepScans) : (1))),
+           (unsigned long long)(stats.busTimeUs / ((sweepScans > 0) ? (sweepScans) : (1))), (unsigned long)sweepScans,
+           (unsigned long)initial, (unsigned long)unsettled, (unsigned long)updated, (unsigned long)faults);
+    return initial + unsettled + updated + faults + ((sweepScans == 0) ? (1) : (0));
+}
+
+static void moveCellVoltages(uint32_t numBmbs)
+{
+    for(uint32_t i = 0; i < numBmbs; i++)
+    {
+        for(uint32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+        {
+            float voltage = simGetCellVoltage(i, cell) + 0.1f;
+            simSetCellVoltage(i, cell, (voltage > 4.5f) ? (voltage - 1.0f) : (voltage));
+        }
+    }
+}
+
+static void resetDriverChainState(uint32_t numBmbs)
+{
+    // Isolate the whole chain so the driver drops whatever break it last found,
+    // then restore it and let the driver enumerate the complete chain
+    simInit(numBmbs);
+    simBreakLink(0);
+    simBreakLink(numBmbs);
+    runScan(numBmbs);
+    simRepairLinks();
+    for(int32_t i = 0; i < SIM_WARMUP_SCANS; i++)
+    {
+        runScan(numBmbs);
+    }
+}
+
+static uint32_t runChainBreakScenario(uint32_t numBmbs)
+{
+    printf("\nChain break recovery (%lu bmbs)\n", (unsigned long)numBmbs);
+    printf("| Broken link | Scans | Frames | Bytes | Bus time (us) | Bad cells |\n");
+    printf("|-------------|-------|--------|-------|---------------|-----------|\n");
+
+    uint32_t totalMismatches = 0;
+    uint64_t totalBusTimeUs = 0;
+    uint64_t worstBusTimeUs = 0;
+    for(uint32_t link = 0; link <= numBmbs; link++)
+    {
+        resetDriverChainState(numBmbs);
+
+        // Conversions capture the cell voltages when they start, so move the cells one scan ahead
+        // of the break to make sure stale data cannot pass the check
+        moveCellVoltages(numBmbs);
+        runScan(numBmbs);
+
+        // Break the link between scans and count bus activity until every cell reads back correctly
+        simBreakLink(link);
+        simResetStats();
+
+        uint32_t scans = 0;
+        uint32_t mismatches = 0;
+        do
+        {
+            runScan(numBmbs);
+            scans++;
+            mismatches = countVoltageMismatches(numBmbs);
+        } while((mismatches != 0) && (scans < SIM_BREAK_MAX_SCANS));
+        SimStats_S stats = simGetStats();
+
+        totalMismatches += mismatches;
+        totalBusTimeUs += stats.busTimeUs;
+        worstBusTimeUs = (stats.busTimeUs > worstBusTimeUs) ? (stats.busTimeUs) : (worstBusTimeUs);
+
+        printf("| %11lu | %5lu | %6lu | %5lu | %13llu | %9lu |\n",
+               (unsigned long)link, (unsigned long)scans, (unsigned long)stats.frames, (unsigned long)stats.bytes,
+               (unsigned long long)stats.busTimeUs, (unsigned long)mismatches);
+    }
+    printf("Mean bus time to recover: %.0f us, worst: %llu us\n",
+           (double)totalBusTimeUs / (numBmbs + 1), (unsigned long long)worstBusTimeUs);
+    return totalMismatches;
+}
+
+static uint32_t runNoiseScenario(uint32_t numBmbs)
+{
+    static const float errorRates[] = { 0.0f, 0.01f, 0.02f, 0.05f, 0.10f };
+
+    printf("\nRead noise (%lu bmbs, %d scans per rate)\n", (unsigned long)numBmbs, SIM_NOISE_SCANS);
+    printf("| Packet error rate | Fresh cells (%%) | Frames/scan | Bytes/scan | Bus time/scan (us) |\n");
+    printf("|-------------------|-----------------|-------------|------------|--------------------|\n");
+
+    uint32_t failures = 0;
+    for(uint32_t i = 0; i < sizeof(errorRates) / sizeof(errorRates[0]); i++)
+    {
+        resetDriverChainState(numBmbs);
+        simSetReadErrorRate(errorRates[i]);
+        simResetStats();
+
+        // Each scan reads the conversion started at the end of the previous scan. Cells move
+        // every scan, so only data read during that scan matches the voltages it converted
+        uint64_t freshCells = 0;
+        for(int32_t scan = 0; scan < SIM_NOISE_SCANS; scan++)
+        {
+            saveConvertedVoltages(numBmbs);
+            moveCellVoltages(numBmbs);
+            runScan(numBmbs);
+            freshCells += countFreshCells(numBmbs);
+        }
+        SimStats_S stats = simGetStats();
+
+        double freshPercent = (100.0 * freshCells) / ((double)numBmbs * SIM_CELLS_PER_BMB * SIM_NOISE_SCANS);
+        printf("| %17.2f | %15.2f | %11.1f | %10.1f | %18.1f |\n",
+               (double)errorRates[i], freshPercent,
+               (double)stats.frames / SIM_NOISE_SCANS,
+               (double)stats.bytes / SIM_NOISE_SCANS,
+               (double)stats.busTimeUs / SIM_NOISE_SCANS);
+
+        // A clean bus must deliver every sample
+        if((errorRates[i] == 0.0f) && (freshCells != ((uint64_t)numBmbs * SIM_CELLS_PER_BMB * SIM_NOISE_SCANS)))
+        {
+            failures++;
+        }
+    }
+    simSetReadErrorRate(0.0f);
+    return failures;
+}
+
+static void saveConvertedVoltages(uint32_t numBmbs)
+{
+    // The next scan reads back the conversion of the voltages held until the cells next move
+    for(uint32_t j = 0; j < numBmbs; j++)
+    {
+        for(uint32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+        {
+            convertedVoltage[j][cell] = simGetCellVoltage(j, cell);
+        }
+    }
+}
+
+static uint64_t countFreshCells(uint32_t numBmbs)
+{
+    // A scan that has to frame its snapshot again may read a conversion of the voltages after the move,
+    // which is fresher still
+    uint64_t freshCells = 0;
+    for(uint32_t j = 0; j < numBmbs; j++)
+    {
+        for(uint32_t cell = 0; cell < SIM_CELLS_PER_BMB; cell++)
+        {
+            if((pack.cellVoltageValid[j] & (1UL << cell)) &&
+               ((fabsf(adcCodeToVolts(pack.cellVoltage[j][cell]) - convertedVoltage[j][cell]) <= SIM_VOLTAGE_TOLERANCE) ||
+                (fabsf(adcCodeToVolts(pack.cellVoltage[j][cell]) - simGetCellVoltage(j, cell)) <= SIM_VOLTAGE_TOLERANCE)))
+            {
+                freshCells++;
+            }
+        }
+    }
+    return freshCells;
+}
+
+static bool isFreshAtPeriod(uint32_t numBmbs, uint64_t periodUs, uint64_t *scanTimeUs)
+{
+    resetDriverChainState(numBmbs);
+    runScanWithPeriod(numBmbs, periodUs);
+
+    // Every cell of every scan must come from the conversion started by the scan before it
+    bool fresh = true;
+    uint64_t startUs = simGetTimeUs();
+    for(int32_t scan = 0; scan < SIM_RATE_SCANS; scan++)
+    {
+        saveConvertedVoltages(numBmbs);
+        moveCellVoltages(numBmbs);
+        runScanWithPeriod(numBmbs, periodUs);
+        fresh &= (countFreshCells(numBmbs) == ((uint64_t)numBmbs * SIM_CELLS_PER_BMB));
+    }
+    *scanTimeUs = (simGetTimeUs() - startUs) / SIM_RATE_SCANS;
+    return fresh;
+}
+
+static uint32_t runScanRateScenario(uint32_t numBmbs)
+{
+    static bool headerPrinted = false;
+    if(!headerPrinted)
+    {
+        printf("Scan rate (%d us conversion)\n", SIM_CONVERSION_TIME_US);
+        printf("| BMBs | Bus time/scan (us) | Min scan period (us) | Max scan rate (Hz) |\n");
+        printf("|------|--------------------|----------------------|--------------------|\n");
+        headerPrinted = true;
+    }
+
+    // Bisect for the shortest period where no scan reads a stale or unfinished conversion
+    uint64_t scanTimeUs = 0;
+    if(!isFreshAtPeriod(numBmbs, SIM_SCAN_PERIOD_US, &scanTimeUs))
+    {
+        printf("| %4lu | stale data at the nominal %d us period |\n", (unsigned long)numBmbs, SIM_SCAN_PERIOD_US);
+        return 1;
+    }
+    uint64_t passUs = SIM_SCAN_PERIOD_US;
+    uint64_t failUs = 0;
+    while((passUs - failUs) > SIM_RATE_RESOLUTION_US)
+    {
+        uint64_t periodUs = (passUs + failUs) / 2;
+        if(isFreshAtPeriod(numBmbs, periodUs, &scanTimeUs))
+        {
+            passUs = periodUs;
+        }
+        else
+        {
+            failUs = periodUs;
+        }
+    }
+
+    // A period shorter than the bus time of a scan runs the scans back to back
+    isFreshAtPeriod(numBmbs, passUs, &scanTimeUs);
+    simResetStats();
+    runScanWithPeriod(numBmbs, passUs);
+    SimStats_S stats = simGetStats();
+
+    printf("| %4lu | %18llu | %20llu | %18.1f |\n",
+           (unsigned long)numBmbs, (unsigned long long)stats.busTimeUs,
+           (unsigned long long)scanTimeUs, 1000000.0 / scanTimeUs);
+    return 0;
+}
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+int main(int argc, char **argv)
+{
+    // --breaks measures recovery from a break at every link instead of the steady state scan
+    // --noise measures how many samples survive random read errors
+    // --rate measures the shortest scan period that still delivers every sample
+    uint32_t (*scenario)(uint32_t) = NULL;
+    if((argc > 1) && (strcmp(argv[1], "--breaks") == 0))
+    {
+        scenario = runChainBreakScenario;
+    }
+    else if((argc > 1) && (strcmp(argv[1], "--noise") == 0))
+    {
+        scenario = runNoiseScenario;
+    }
+    else if((argc > 1) && (strcmp(argv[1], "--rate") == 0))
+    {
+        scenario = runScanRateScenario;
+    }
+    if(scenario != NULL)
+    {
+        argc--;
+        argv++;
+    }
+
+    // Chain lengths to simulate can be listed on the command line, otherwise every length is swept
+    uint32_t chainLengths[SIM_MAX_BMBS];
+    uint32_t numChainLengths = 0;
+    for(int32_t i = 1; i < argc; i++)
+    {
+        uint32_t numBmbs = (uint32_t)strtoul(argv[i], NULL, 0);
+        if((numBmbs < 1) || (numBmbs > SIM_MAX_BMBS) || (numChainLengths >= SIM_MAX_BMBS))
+        {
+            fprintf(stderr, "usage: %s [--breaks | --noise | --rate] [numBmbs ...] (1 - %d)\n", argv[0], SIM_MAX_BMBS);
+            return 1;
+        }
+        chainLengths[numChainLengths++] = numBmbs;
+    }
+    if(scenario != NULL)
+    {
+        uint32_t totalMismatches = 0;
+        if(numChainLengths == 0)
+        {
+            totalMismatches += scenario(16);
+            totalMismatches += scenario(32);
+        }
+        for(uint32_t n = 0; n < numChainLengths; n++)
+        {
+            totalMismatches += scenario(chainLengths[n]);
+        }
+        totalMismatches += reportStatsMismatches();
+        return (totalMismatches == 0) ? (0) : (1);
+    }
+
+    if(numChainLengths == 0)
+    {
+        for(uint32_t numBmbs = 1; numBmbs <= SIM_MAX_BMBS; numBmbs++)
+        {
+            chainLengths[numChainLengths++] = numBmbs;
+        }
+    }
+
+    printf("| BMBs | Frames/scan | Bytes/scan | CS edges/scan | Bus time/scan (us) | ISRs/scan | CPU load (%%) | Bad cells |\n");
+    printf("|------|-------------|------------|---------------|--------------------|-----------|--------------|-----------|\n");
+
+    uint32_t totalMismatches = 0;
+    for(uint32_t n = 0; n < numChainLengths; n++)
+    {
+        uint32_t numBmbs = chainLengths[n];
+        simInit(numBmbs);
+
+        // Let the driver enumerate the chain and sync command counters before measuring
+        for(int32_t i = 0; i < SIM_WARMUP_SCANS; i++)
+        {
+            runScan(numBmbs);
+        }
+
+        simResetStats();
+        for(int32_t i = 0; i < SIM_MEASURED_SCANS; i++)
+        {
+            runScan(numBmbs);
+        }
+        SimStats_S stats = simGetStats();
+
+        uint32_t mismatches = countVoltageMismatches(numBmbs);
+        totalMismatches += mismatches;
+
+        // CPU load is the estimated driver cycles spent per scan period
+        double cpuLoad = (100.0 * stats.cpuCycles) / ((double)SIM_CPU_CLOCK_HZ * SIM_SCAN_PERIOD_US / 1000000 * SIM_MEASURED_SCANS);
+
+        printf("| %4lu | %11.1f | %10.1f | %13.1f | %18.1f | %9.1f | %12.3f | %9lu |\n",
+               (unsigned long)numBmbs,
+               (double)stats.frames / SIM_MEASURED_SCANS,
+               (double)stats.bytes / SIM_MEASURED_SCANS,
+               (double)stats.csTransitions / SIM_MEASURED_SCANS,
+               (double)stats.busTimeUs / SIM_MEASURED_SCANS,
+               (double)stats.interrupts / SIM_MEASURED_SCANS,
+               cpuLoad,
+               (unsigned long)mismatches);
+    }
+    printf("SPI transport: %s\n", simGetSpiTransport());
+
+    totalMismatches += runBulkFallbackScenario();
+    totalMismatches += runPorRecoveryScenario();
+    totalMismatches += runSnapshotCoherenceScenario();
+    totalMismatches += runCellLimitScenario();
+    totalMismatches += runRedundantAdcScenario();
+    totalMismatches += runOpenWireScenario();
+    totalMismatches += runDiagnosticScenario();
+    totalMismatches += runSumOfCellsScenario();
+    totalMismatches += runThermistorScenario();
+    totalMismatches += reportStatsMismatches();
+
+    return (totalMismatches == 0) ? (0) : (1);
+}
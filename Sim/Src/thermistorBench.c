@@ -0,0 +1,251 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "bmb.h"
+#include "thermistor.h"
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+#define BENCH_NUM_CODES         4096
+#define BENCH_REPETITIONS       256
+
+// Largest difference from the analytic curve the table may have, including rounding to 0.1 C
+#define BENCH_MAX_ERROR_C       0.1
+
+#define BENCH_KELVIN_OFFSET     273.15
+
+// Temperature bands the error is reported over, in C
+#define BENCH_BAND_WIDTH_C      40
+#define BENCH_NUM_BANDS         ((THERMISTOR_TABLE_MAX_DECI_C - THERMISTOR_TABLE_MIN_DECI_C) / (BENCH_BAND_WIDTH_C * 10))
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+typedef struct
+{
+    uint32_t numCodes;
+    double maxError;
+    double sumSquaredError;
+    double maxCodeStep;     // Largest temperature change between neighbouring codes
+} ErrorBand_S;
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static int16_t codes[BENCH_NUM_CODES];
+static uint32_t rngState = 0x6830A5A5;
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DECLARATIONS ==================== */
+/* ==================================================================== */
+
+static uint32_t nextRandom(void);
+static double analyticTemperature(int16_t code);
+static int16_t logTemperature(int16_t code);
+static void addError(ErrorBand_S *band, double error, double codeStep);
+static uint32_t reportErrors(void);
+static uint32_t checkFaults(void);
+static double benchmarkTable(int32_t *sink);
+static double benchmarkLog(int32_t *sink);
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+static uint32_t nextRandom(void)
+{
+    // xorshift32 keeps the codes reproducible between runs
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static double analyticTemperature(int16_t code)
+{
+    // Invert the divider and the beta curve in double precision. NAN outside the supply rails
+    double volts = (double)adcCodeToVolts(code);
+    if((volts <= 0.0) || (volts >= THERMISTOR_SUPPLY_VOLTS))
+    {
+        return NAN;
+    }
+    double ohms = (THERMISTOR_PULLUP_OHMS * volts) / (THERMISTOR_SUPPLY_VOLTS - volts);
+    double kelvin = 1.0 / ((1.0 / (THERMISTOR_NOMINAL_C + BENCH_KELVIN_OFFSET)) + (log(ohms / THERMISTOR_NOMINAL_OHMS) / THERMISTOR_BETA));
+    return kelvin - BENCH_KELVIN_OFFSET;
+}
+
+static int16_t logTemperature(int16_t code)
+{
+    // The single precision Steinhart-Hart beta conversion the table replaces
+    float volts = adcCodeToVolts(code);
+    float ohms = ((float)THERMISTOR_PULLUP_OHMS * volts) / ((float)THERMISTOR_SUPPLY_VOLTS - volts);
+    float kelvin = 1.0f / ((1.0f / (float)(THERMISTOR_NOMINAL_C + BENCH_KELVIN_OFFSET)) +
+                           (logf(ohms / (float)THERMISTOR_NOMINAL_OHMS) / (float)THERMISTOR_BETA));
+    return (int16_t)lrintf((kelvin - (float)BENCH_KELVIN_OFFSET) * 10.0f);
+}
+
+static void addError(ErrorBand_S *band, double error, double codeStep)
+{
+    band->numCodes++;
+    band->maxError = (fabs(error) > band->maxError) ? (fabs(error)) : (band->maxError);
+    band->sumSquaredError += error * error;
+    band->maxCodeStep = (codeStep > band->maxCodeStep) ? (codeStep) : (band->maxCodeStep);
+}
+
+static uint32_t reportErrors(void)
+{
+    ErrorBand_S bands[BENCH_NUM_BANDS + 1] = { 0 };
+    ErrorBand_S logErrors = { 0 };
+
+    // Every code the table converts, against the analytic curve
+    for(int32_t code = INT16_MIN; code <= INT16_MAX; code++)
+    {
+        int16_t temperature;
+        if(thermistorCodeToTemperature((int16_t)code, &temperature) != THERMISTOR_OK)
+        {
+            continue;
+        }
+
+        double exact = analyticTemperature((int16_t)code);
+        double codeStep = fabs(analyticTemperature((int16_t)(code - 1)) - exact);
+        double error = (temperature / 10.0) - exact;
+        int32_t band = (int32_t)((exact * 10.0) - THERMISTOR_TABLE_MIN_DECI_C) / (BENCH_BAND_WIDTH_C * 10);
+        band = (band < 0) ? (0) : ((band >= BENCH_NUM_BANDS) ? (BENCH_NUM_BANDS - 1) : (band));
+        addError(&bands[band], error, codeStep);
+        addError(&bands[BENCH_NUM_BANDS], error, codeStep);
+        addError(&logErrors, (logTemperature((int16_t)code) / 10.0) - exact, codeStep);
+    }
+
+    printf("| Range (C)    | Codes | Max error (C) | RMS error (C) | Largest code step (C) |\n");
+    printf("|--------------|-------|---------------|---------------|-----------------------|\n");
+    for(int32_t i = 0; i <= BENCH_NUM_BANDS; i++)
+    {
+        char range[16];
+        if(i < BENCH_NUM_BANDS)
+        {
+            int32_t low = (THERMISTOR_TABLE_MIN_DECI_C / 10) + (i * BENCH_BAND_WIDTH_C);
+            snprintf(range, sizeof(range), "%4ld to %4ld", (long)low, (long)(low + BENCH_BAND_WIDTH_C));
+        }
+        else
+        {
+            snprintf(range, sizeof(range), "%-12s", "All");
+        }
+        printf("| %s | %5lu | %13.3f | %13.3f | %21.3f |\n", range, (unsigned long)bands[i].numCodes, bands[i].maxError,
+               sqrt(bands[i].sumSquaredError / ((bands[i].numCodes > 0) ? (bands[i].numCodes) : (1))), bands[i].maxCodeStep);
+    }
+    printf("Single precision log conversion over the same codes: max error %.3f C, RMS %.3f C\n", logErrors.maxError,
+           sqrt(logErrors.sumSquaredError / logErrors.numCodes));
+
+    return (bands[BENCH_NUM_BANDS].maxError <= BENCH_MAX_ERROR_C) ? (0) : (1);
+}
+
+static uint32_t checkFaults(void)
+{
+    // A code may only read as open if it is colder than the table or at the supply, and as a short if it is
+    // hotter than the table or at ground. Within a rounding step of either end both answers are right
+    const double minC = THERMISTOR_TABLE_MIN_DECI_C / 10.0;
+    const double maxC = THERMISTOR_TABLE_MAX_DECI_C / 10.0;
+    uint32_t wrong = 0;
+    uint32_t numOpen = 0;
+    uint32_t numShort = 0;
+    for(int32_t code = INT16_MIN; code <= INT16_MAX; code++)
+    {
+        int16_t temperature;
+        THERMISTOR_STATUS_E status = thermistorCodeToTemperature((int16_t)code, &temperature);
+        double exact = analyticTemperature((int16_t)code);
+        double volts = (double)adcCodeToVolts((int16_t)code);
+        bool cold = (volts >= THERMISTOR_SUPPLY_VOLTS) || (exact < (minC + BENCH_MAX_ERROR_C));
+        bool hot = (volts <= 0.0) || (exact > (maxC - BENCH_MAX_ERROR_C));
+        bool inTable = (volts > 0.0) && (volts < THERMISTOR_SUPPLY_VOLTS) &&
+                       (exact > (minC - BENCH_MAX_ERROR_C)) && (exact < (maxC + BENCH_MAX_ERROR_C));
+
+        numOpen += (status == THERMISTOR_OPEN) ? (1) : (0);
+        numShort += (status == THERMISTOR_SHORT) ? (1) : (0);
+        wrong += ((status == THERMISTOR_OPEN) && !cold) ? (1) : (0);
+        wrong += ((status == THERMISTOR_SHORT) && !hot) ? (1) : (0);
+        wrong += ((status == THERMISTOR_OK) && !inTable) ? (1) : (0);
+    }
+
+    printf("Fault flags over every code: %lu open, %lu short, %lu wrong\n", (unsigned long)numOpen, (unsigned long)numShort,
+           (unsigned long)wrong);
+    return wrong;
+}
+
+static double benchmarkTable(int32_t *sink)
+{
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int32_t rep = 0; rep < BENCH_REPETITIONS; rep++)
+    {
+        for(int32_t i = 0; i < BENCH_NUM_CODES; i++)
+        {
+            int16_t temperature;
+            *sink += thermistorCodeToTemperature(codes[i], &temperature) + temperature;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsedNs = ((end.tv_sec - start.tv_sec) * 1e9) + (end.tv_nsec - start.tv_nsec);
+    return elapsedNs / ((double)BENCH_REPETITIONS * BENCH_NUM_CODES);
+}
+
+static double benchmarkLog(int32_t *sink)
+{
+    struct timespec start;
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int32_t rep = 0; rep < BENCH_REPETITIONS; rep++)
+    {
+        for(int32_t i = 0; i < BENCH_NUM_CODES; i++)
+        {
+            *sink += logTemperature(codes[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsedNs = ((end.tv_sec - start.tv_sec) * 1e9) + (end.tv_nsec - start.tv_nsec);
+    return elapsedNs / ((double)BENCH_REPETITIONS * BENCH_NUM_CODES);
+}
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+int main(void)
+{
+    printf("Thermistor table: beta %.0f, %.0f ohm at %.0f C, %.0f ohm pull-up to %.2f V, %d segments from %.1f C to %.1f C\n",
+           THERMISTOR_BETA, THERMISTOR_NOMINAL_OHMS, THERMISTOR_NOMINAL_C, THERMISTOR_PULLUP_OHMS, THERMISTOR_SUPPLY_VOLTS,
+           NUM_THERMISTOR_TABLE_SEGMENTS, THERMISTOR_TABLE_MIN_DECI_C / 10.0, THERMISTOR_TABLE_MAX_DECI_C / 10.0);
+    uint32_t failures = reportErrors();
+    failures += checkFaults();
+
+    // Codes spread over the table, as the thermistors of a pack would read
+    int16_t hotCode;
+    int16_t coldCode;
+    int16_t temperature;
+    for(hotCode = INT16_MIN; thermistorCodeToTemperature(hotCode, &temperature) != THERMISTOR_OK; hotCode++);
+    for(coldCode = INT16_MAX; thermistorCodeToTemperature(coldCode, &temperature) != THERMISTOR_OK; coldCode--);
+    for(int32_t i = 0; i < BENCH_NUM_CODES; i++)
+    {
+        codes[i] = (int16_t)(hotCode + (int32_t)(nextRandom() % (uint32_t)(coldCode - hotCode + 1)));
+    }
+
+    int32_t sink = 0;
+    double tableNs = benchmarkTable(&sink);
+    double logNs = benchmarkLog(&sink);
+    printf("| Conversion              | Time (ns) |\n");
+    printf("|-------------------------|-----------|\n");
+    printf("| Table interpolation     | %9.2f |\n", tableNs);
+    printf("| Single precision logf   | %9.2f |\n", logNs);
+    printf("(checksum %08X)\n", (unsigned int)sink);
+
+    return (failures == 0) ? (0) : (1);
+}